@@ -1,8 +1,20 @@
 #pragma once
 
 #include "async/Macros.hpp"
+#include "async/AsyncChannel.hpp"
+#include "async/AsyncMutex.hpp"
+#include "async/AsyncSemaphore.hpp"
+#include "async/Cancellation.hpp"
+#include "async/Combinators.hpp"
+#include "async/Executor.hpp"
+#include "async/File.hpp"
 #include "async/Future.hpp"
+#include "async/MainThreadExecutor.hpp"
+#include "async/Reactor.hpp"
 #include "async/Runtime.hpp"
+#include "async/Stream.hpp"
+#include "async/Task.hpp"
+#include "async/Timer.hpp"
 
 namespace asp {
     using namespace ::asp::async;
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "../config.hpp"
+#include "Future.hpp"
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace asp::async {
+
+// Message queue for exchanging data between tasks, that suspends instead of blocking a thread.
+// Unlike `sync::Channel`, `recv()` returns a future that completes once a message is available, so a coroutine can `co_await` it
+// without occupying a worker. If the channel is bounded, `send()` returns a future that completes once there is room for the message.
+// Waiting receivers are completed by the sender directly, in FIFO order. Receivers that have been cancelled, for example by
+// `withTimeout`, are skipped, so their message goes to the next receiver or stays in the queue. Likewise, the message of a
+// sender that has been cancelled while waiting for room is never queued.
+template <typename T>
+class AsyncChannel {
+public:
+    // Creates a channel that holds at most `capacity` messages, or an unbounded one if `capacity` is 0.
+    explicit AsyncChannel(size_t capacity = 0) : capacity(capacity) {}
+
+    AsyncChannel(const AsyncChannel&) = delete;
+    AsyncChannel& operator=(const AsyncChannel&) = delete;
+
+    // Returns a future that completes with the message at the front of the queue, once there is one.
+    FutureHandle<T> recv() {
+        std::unique_lock lock(mtx);
+
+        if (queue.empty()) {
+            auto fut = detail::makeFuture<T>();
+
+            if (closed) {
+                lock.unlock();
+                fut->cancel();
+            } else {
+                receivers.push_back(fut);
+            }
+
+            return FutureHandle<T>(std::move(fut));
+        }
+
+        auto fut = detail::makeFuture<T>();
+        fut->resolve(std::move(queue.front()));
+        queue.pop_front();
+
+        // a slot has been freed, let the oldest blocked sender in
+        auto sender = this->admitSender();
+        lock.unlock();
+
+        if (sender) sender->resolve();
+
+        return FutureHandle<T>(std::move(fut));
+    }
+
+    // Returns the message at the front of the queue if there is one, without waiting.
+    std::optional<T> tryRecv() {
+        std::unique_lock lock(mtx);
+
+        if (queue.empty()) return std::nullopt;
+
+        std::optional<T> val(std::move(queue.front()));
+        queue.pop_front();
+
+        auto sender = this->admitSender();
+        lock.unlock();
+
+        if (sender) sender->resolve();
+
+        return val;
+    }
+
+    // Sends a message. The returned future completes once the message has been queued,
+    // which is right away unless the channel is bounded and full.
+    FutureHandle<void> send(T msg) {
+        auto fut = detail::makeFuture<void>();
+        std::unique_lock lock(mtx);
+
+        if (closed) {
+            lock.unlock();
+            fut->resolve();
+        } else if (auto receiver = this->takeReceiver()) {
+            lock.unlock();
+            receiver->resolve(std::move(msg));
+            fut->resolve();
+        } else if (capacity == 0 || queue.size() < capacity) {
+            queue.push_back(std::move(msg));
+            lock.unlock();
+            fut->resolve();
+        } else {
+            senders.emplace_back(std::move(msg), fut);
+        }
+
+        return FutureHandle<void>(std::move(fut));
+    }
+
+    // Sends a message if it can be done without waiting, returns `false` if the channel is full or closed.
+    bool trySend(T msg) {
+        std::unique_lock lock(mtx);
+
+        if (closed) return false;
+
+        if (auto receiver = this->takeReceiver()) {
+            lock.unlock();
+            receiver->resolve(std::move(msg));
+            return true;
+        }
+
+        if (capacity != 0 && queue.size() >= capacity) {
+            return false;
+        }
+
+        queue.push_back(std::move(msg));
+        return true;
+    }
+
+    // Returns the amount of queued messages, not including ones from senders that are waiting for room.
+    size_t size() const {
+        std::lock_guard lock(mtx);
+        return queue.size();
+    }
+
+    bool empty() const {
+        return this->size() == 0;
+    }
+
+    // Closes the channel, for when nobody is going to receive from it anymore. Queued messages are dropped, and senders that
+    // are waiting for room complete right away, as does every later `send()`, without queuing their message.
+    // Waiting and later receivers are cancelled.
+    void close() {
+        std::unique_lock lock(mtx);
+
+        closed = true;
+
+        auto dropped = std::exchange(queue, {});
+        auto waitingSenders = std::exchange(senders, {});
+        auto waitingReceivers = std::exchange(receivers, {});
+
+        lock.unlock();
+
+        for (auto& sender : waitingSenders) {
+            if (sender.second->claim()) sender.second->resolve();
+        }
+
+        for (auto& receiver : waitingReceivers) {
+            receiver->cancel();
+        }
+    }
+
+    bool isClosed() const {
+        std::lock_guard lock(mtx);
+        return closed;
+    }
+
+private:
+    mutable std::mutex mtx;
+    std::deque<T> queue;
+    std::deque<detail::FutureRef<T>> receivers;
+    std::deque<std::pair<T, detail::FutureRef<void>>> senders;
+    size_t capacity;
+    bool closed = false;
+
+    // Must be called with `mtx` locked. Returns the oldest receiver that is still waiting, claimed so that it can no longer be
+    // cancelled before the message is handed to it.
+    detail::FutureRef<T> takeReceiver() {
+        while (!receivers.empty()) {
+            auto receiver = std::move(receivers.front());
+            receivers.pop_front();
+
+            if (receiver->claim()) {
+                return receiver;
+            }
+        }
+
+        return {};
+    }
+
+    // Must be called with `mtx` locked. Moves the message of the oldest sender that is still waiting into the queue, returns
+    // its future. Senders that have been cancelled are dropped along with their message.
+    detail::FutureRef<void> admitSender() {
+        while (!senders.empty()) {
+            auto [msg, fut] = std::move(senders.front());
+            senders.pop_front();
+
+            if (fut->claim()) {
+                queue.push_back(std::move(msg));
+                return std::move(fut);
+            }
+        }
+
+        return {};
+    }
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../config.hpp"
+#include "AsyncSemaphore.hpp"
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace asp::async {
+
+// Mutex for coroutines, like `sync::Mutex` it owns the data it protects. Locking it suspends the coroutine while the mutex is held
+// by someone else, rather than blocking the thread, so it can be held across `co_await`s. Waiters acquire the mutex in FIFO order.
+//
+// ```
+// auto guard = co_await mtx.lock();
+// guard->push_back(1);
+// ```
+template <typename Inner = void>
+class AsyncMutex {
+    using Storage = std::conditional_t<std::is_void_v<Inner>, std::monostate, Inner>;
+
+public:
+    AsyncMutex() : data(), sem(1) {}
+
+    template <typename U> requires (!std::is_void_v<Inner> && std::is_constructible_v<Storage, U&&>)
+    AsyncMutex(U&& obj) : data(std::forward<U>(obj)), sem(1) {}
+
+    AsyncMutex(const AsyncMutex&) = delete;
+    AsyncMutex& operator=(const AsyncMutex&) = delete;
+
+    class Guard {
+    public:
+        Guard(Guard&&) = default;
+        Guard& operator=(Guard&&) = default;
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        // Unlocks the mutex. Any access to this `Guard` afterwards invokes undefined behavior.
+        void unlock() {
+            permit.release();
+        }
+
+        template <typename U = Inner> requires (!std::is_void_v<U>)
+        U& operator*() const {
+            return mtx->data;
+        }
+
+        template <typename U = Inner> requires (!std::is_void_v<U>)
+        U* operator->() const {
+            return &mtx->data;
+        }
+
+    private:
+        friend class AsyncMutex;
+
+        AsyncSemaphore::Permit permit;
+        const AsyncMutex* mtx;
+
+        Guard(AsyncSemaphore::Permit&& permit, const AsyncMutex* mtx) : permit(std::move(permit)), mtx(mtx) {}
+    };
+
+    class Lock {
+    public:
+        bool await_ready() {
+            return inner.await_ready();
+        }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            return inner.await_suspend(h);
+        }
+
+        Guard await_resume() {
+            return Guard(inner.await_resume(), mtx);
+        }
+
+    private:
+        friend class AsyncMutex;
+
+        AsyncSemaphore::Acquire inner;
+        const AsyncMutex* mtx;
+
+        Lock(const AsyncMutex* mtx) : inner(mtx->sem.acquire()), mtx(mtx) {}
+    };
+
+    // Returns an awaitable that completes with a `Guard` once the mutex is locked.
+    Lock lock() const {
+        return Lock(this);
+    }
+
+    // Locks the mutex if it is not currently held.
+    std::optional<Guard> tryLock() const {
+        auto permit = sem.tryAcquire();
+        if (!permit) return std::nullopt;
+
+        return Guard(std::move(*permit), this);
+    }
+
+private:
+    mutable Storage data;
+    mutable AsyncSemaphore sem;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "../config.hpp"
+#include "Executor.hpp"
+
+#include <coroutine>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace asp::async {
+
+// Semaphore for coroutines, useful for limiting concurrency, for example to at most 8 concurrent disk reads.
+// Waiting for a permit suspends the coroutine rather than blocking its thread. Waiters are queued intrusively,
+// in the frames of the awaiting coroutines, and are handed the released permits in FIFO order.
+//
+// ```
+// auto permit = co_await sem.acquire();
+// ```
+class AsyncSemaphore {
+public:
+    // Held permit, returned to the semaphore when destroyed.
+    class Permit {
+    public:
+        Permit(Permit&& other) noexcept : sem(std::exchange(other.sem, nullptr)) {}
+
+        Permit& operator=(Permit&& other) noexcept {
+            if (this != &other) {
+                this->release();
+                sem = std::exchange(other.sem, nullptr);
+            }
+
+            return *this;
+        }
+
+        Permit(const Permit&) = delete;
+        Permit& operator=(const Permit&) = delete;
+
+        ~Permit() {
+            this->release();
+        }
+
+        // Returns the permit early. Does nothing if it has already been released.
+        void release() {
+            if (sem) {
+                std::exchange(sem, nullptr)->release();
+            }
+        }
+
+    private:
+        friend class AsyncSemaphore;
+
+        AsyncSemaphore* sem;
+
+        Permit(AsyncSemaphore* sem) : sem(sem) {}
+    };
+
+    class Acquire {
+    public:
+        bool await_ready() {
+            return sem.tryTake();
+        }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            handle = h;
+            executor = &currentExecutor();
+            return sem.enqueue(this);
+        }
+
+        Permit await_resume() {
+            return Permit(&sem);
+        }
+
+    private:
+        friend class AsyncSemaphore;
+
+        AsyncSemaphore& sem;
+        std::coroutine_handle<> handle;
+        // where the waiter is resumed, the executor it was suspended on
+        Executor* executor = nullptr;
+        Acquire* next = nullptr;
+
+        Acquire(AsyncSemaphore& sem) : sem(sem) {}
+    };
+
+    explicit AsyncSemaphore(size_t permits);
+
+    AsyncSemaphore(const AsyncSemaphore&) = delete;
+    AsyncSemaphore& operator=(const AsyncSemaphore&) = delete;
+
+    // Returns an awaitable that completes with a `Permit` once one is available.
+    Acquire acquire() {
+        return Acquire(*this);
+    }
+
+    // Takes a permit if one is available right now.
+    std::optional<Permit> tryAcquire() {
+        if (!this->tryTake()) return std::nullopt;
+        return Permit(this);
+    }
+
+    // Returns a permit to the semaphore. If a coroutine is waiting, the permit is handed to it and it is resumed on the executor
+    // it was suspended on, see `currentExecutor()`.
+    // Normally called by `Permit`, but can also be used to add permits.
+    void release();
+
+    // Returns the amount of currently available permits.
+    size_t available() const;
+
+private:
+    mutable std::mutex mtx;
+    size_t permits;
+    Acquire* head = nullptr;
+    Acquire* tail = nullptr;
+
+    bool tryTake();
+    // Queues the waiter, returns `false` if a permit was taken instead and the coroutine should not suspend.
+    bool enqueue(Acquire* waiter);
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../config.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+namespace asp::async {
+
+namespace detail {
+    class CancellationState;
+}
+
+// Error that a cancelled future fails with.
+class CancelledError : public std::runtime_error {
+public:
+    CancelledError() : std::runtime_error("future was cancelled") {}
+};
+
+// Observing side of a `CancellationSource`. Tasks can poll it, or register a callback that runs once it is cancelled.
+// A default constructed token is never cancelled.
+class CancellationToken {
+public:
+    using CallbackId = uint64_t;
+
+    CancellationToken() = default;
+
+    bool isCancelled() const;
+
+    // Throws a `CancelledError` if the token has been cancelled.
+    void throwIfCancelled() const;
+
+    // Registers a callback that is called on the thread that cancels the token, or right away if it is already cancelled.
+    // Returns an id that can be passed to `removeCallback`, or 0 if the callback has already been called.
+    CallbackId onCancel(std::function<void()>&& f) const;
+
+    // Removes a callback that has not been called yet.
+    void removeCallback(CallbackId id) const;
+
+private:
+    friend class CancellationSource;
+
+    std::shared_ptr<detail::CancellationState> state;
+
+    CancellationToken(std::shared_ptr<detail::CancellationState> state) : state(std::move(state)) {}
+};
+
+// Allows cancelling work that has been started with its tokens, for example queued tasks of a player that has disconnected.
+//
+// ```
+// CancellationSource source;
+// auto handle = spawn(source.token(), [] { ... });
+// source.cancel(); // if the task is still queued, it never runs and the handle fails with a `CancelledError`
+// ```
+class CancellationSource {
+public:
+    CancellationSource();
+
+    CancellationToken token() const;
+
+    // Cancels all tokens of this source, calling their callbacks on this thread. Does nothing if already cancelled.
+    void cancel();
+
+    bool isCancelled() const;
+
+private:
+    std::shared_ptr<detail::CancellationState> state;
+};
+
+}
\ No newline at end of file
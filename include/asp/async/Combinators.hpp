@@ -0,0 +1,195 @@
+#pragma once
+
+#include "../config.hpp"
+#include "Future.hpp"
+
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace asp::async {
+
+namespace detail {
+    // Value type used for void futures inside of tuples.
+    template <typename T>
+    using WhenValue = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+    template <typename T>
+    WhenValue<T> takeValue(const FutureHandle<T>& handle) {
+        if constexpr (std::is_void_v<T>) {
+            return {};
+        } else {
+            return handle.getResult();
+        }
+    }
+
+    template <typename Out, typename... Ts>
+    struct WhenAllState {
+        FutureRef<Out> fut = makeFuture<Out>();
+        std::atomic<size_t> remaining = sizeof...(Ts);
+        std::atomic<bool> failed = false;
+        std::tuple<std::optional<WhenValue<Ts>>...> values;
+    };
+
+    template <typename T>
+    struct WhenAllRangeState {
+        using Out = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+        FutureRef<Out> fut = makeFuture<Out>();
+        std::atomic<size_t> remaining;
+        std::atomic<bool> failed = false;
+        std::vector<std::optional<WhenValue<T>>> values;
+
+        WhenAllRangeState(size_t count) : remaining(count), values(count) {}
+    };
+
+    template <typename Out>
+    struct WhenAnyState {
+        FutureRef<Out> fut = makeFuture<Out>();
+        std::atomic<size_t> remaining;
+        std::atomic<bool> done = false;
+
+        WhenAnyState(size_t count) : remaining(count) {}
+    };
+
+    template <typename T, typename Out>
+    void whenAnySubscribe(const std::shared_ptr<WhenAnyState<Out>>& state, const FutureHandle<T>& handle, size_t index) {
+        handle.finally([state, handle, index] {
+            if (handle.hasResult()) {
+                if (state->done.exchange(true, std::memory_order::acq_rel)) return;
+
+                if constexpr (std::is_void_v<T>) {
+                    state->fut->resolve(index);
+                } else {
+                    state->fut->resolve(index, handle.getResult());
+                }
+            } else if (state->remaining.fetch_sub(1, std::memory_order::acq_rel) == 1) {
+                // every future has failed, report the last error
+                if (!state->done.exchange(true, std::memory_order::acq_rel)) {
+                    state->fut->propagate(handle.getError());
+                }
+            }
+        }, InlineExecutor::get());
+    }
+}
+
+// Returns a future that completes with a tuple of the results of all given futures, once all of them finish.
+// Results of void futures are represented as `std::monostate`. Fails as soon as any of the futures fails.
+// Nothing is blocked while waiting, the last future to complete resolves the returned one.
+template <typename... Ts>
+FutureHandle<std::tuple<detail::WhenValue<Ts>...>> whenAll(const FutureHandle<Ts>&... handles) {
+    using Out = std::tuple<detail::WhenValue<Ts>...>;
+    auto state = std::make_shared<detail::WhenAllState<Out, Ts...>>();
+
+    if constexpr (sizeof...(Ts) == 0) {
+        state->fut->resolve();
+    } else {
+        auto subscribe = [&]<size_t... Is>(std::index_sequence<Is...>) {
+            (handles.finally([state, handles] {
+                if (handles.hasError()) {
+                    if (!state->failed.exchange(true, std::memory_order::acq_rel)) {
+                        state->fut->propagate(handles.getError());
+                    }
+
+                    return;
+                }
+
+                std::get<Is>(state->values).emplace(detail::takeValue(handles));
+
+                if (state->remaining.fetch_sub(1, std::memory_order::acq_rel) == 1 && !state->failed.load(std::memory_order::acquire)) {
+                    state->fut->resolve(std::apply([](auto&... vals) { return Out(std::move(*vals)...); }, state->values));
+                }
+            }, InlineExecutor::get()), ...);
+        };
+
+        subscribe(std::index_sequence_for<Ts...>{});
+    }
+
+    return FutureHandle<Out>(state->fut);
+}
+
+// Like the variadic `whenAll`, but for a range of futures of the same type. Completes with a vector of results,
+// in the same order as the given futures, or with nothing if they are void futures.
+template <typename T>
+auto whenAll(const std::vector<FutureHandle<T>>& handles) {
+    using State = detail::WhenAllRangeState<T>;
+    using Out = typename State::Out;
+
+    auto state = std::make_shared<State>(handles.size());
+
+    auto finish = [](State& state) {
+        if constexpr (std::is_void_v<T>) {
+            state.fut->resolve();
+        } else {
+            std::vector<T> out;
+            out.reserve(state.values.size());
+
+            for (auto& val : state.values) {
+                out.emplace_back(std::move(*val));
+            }
+
+            state.fut->resolve(std::move(out));
+        }
+    };
+
+    if (handles.empty()) {
+        finish(*state);
+    }
+
+    for (size_t i = 0; i < handles.size(); i++) {
+        handles[i].finally([state, handle = handles[i], i, finish] {
+            if (handle.hasError()) {
+                if (!state->failed.exchange(true, std::memory_order::acq_rel)) {
+                    state->fut->propagate(handle.getError());
+                }
+
+                return;
+            }
+
+            state->values[i].emplace(detail::takeValue(handle));
+
+            if (state->remaining.fetch_sub(1, std::memory_order::acq_rel) == 1 && !state->failed.load(std::memory_order::acquire)) {
+                finish(*state);
+            }
+        }, InlineExecutor::get());
+    }
+
+    return FutureHandle<Out>(state->fut);
+}
+
+// Returns a future that completes with the index and the result of the first of the given futures to successfully finish.
+// For void futures, only the index is returned. Fails only if all of the futures fail, with the error of the last one.
+template <typename T, typename... Ts> requires (std::is_same_v<T, Ts> && ...)
+auto whenAny(const FutureHandle<T>& first, const FutureHandle<Ts>&... rest) {
+    using Out = std::conditional_t<std::is_void_v<T>, size_t, std::pair<size_t, detail::WhenValue<T>>>;
+
+    auto state = std::make_shared<detail::WhenAnyState<Out>>(1 + sizeof...(Ts));
+
+    size_t index = 0;
+    detail::whenAnySubscribe(state, first, index++);
+    (detail::whenAnySubscribe(state, rest, index++), ...);
+
+    return FutureHandle<Out>(state->fut);
+}
+
+// Like the variadic `whenAny`, but for a range of futures. The range must not be empty.
+template <typename T>
+auto whenAny(const std::vector<FutureHandle<T>>& handles) {
+    using Out = std::conditional_t<std::is_void_v<T>, size_t, std::pair<size_t, detail::WhenValue<T>>>;
+
+    ASP_ALWAYS_ASSERT(!handles.empty(), "cannot call whenAny with no futures");
+
+    auto state = std::make_shared<detail::WhenAnyState<Out>>(handles.size());
+
+    for (size_t i = 0; i < handles.size(); i++) {
+        detail::whenAnySubscribe(state, handles[i], i);
+    }
+
+    return FutureHandle<Out>(state->fut);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "../config.hpp"
+
+#include <coroutine>
+#include <functional>
+
+namespace asp::async {
+
+// Something that is able to run tasks, such as a `Runtime`.
+class Executor {
+public:
+    virtual ~Executor() = default;
+
+    // Schedules the function to be ran by this executor.
+    virtual void execute(std::function<void()>&& f) = 0;
+};
+
+// Executor that runs the function immediately on the calling thread.
+class InlineExecutor : public Executor {
+public:
+    static InlineExecutor& get();
+
+    void execute(std::function<void()>&& f) override {
+        f();
+    }
+};
+
+// Returns the global runtime, `Runtime::get()`.
+Executor& defaultExecutor();
+
+// Returns the executor that the calling thread runs tasks for, which is the runtime owning the worker thread, or the
+// current-thread runtime driven by this thread. On any other thread, returns `InlineExecutor::get()`, so that work is
+// completed on the thread that resolves it rather than on a runtime that may not even be launched.
+// Used to resume work on the runtime it was started on, for example after a timer fires.
+Executor& currentExecutor();
+
+// Moves the awaiting coroutine onto the given executor, for example `co_await resumeOn(Runtime::named("io"))`.
+inline auto resumeOn(Executor& executor) {
+    struct Awaiter {
+        Executor& executor;
+
+        bool await_ready() { return false; }
+
+        void await_suspend(std::coroutine_handle<> h) {
+            executor.execute([h] {
+                h.resume();
+            });
+        }
+
+        void await_resume() {}
+    };
+
+    return Awaiter{executor};
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../config.hpp"
+#include "Future.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace asp::async {
+
+// Positional file I/O that does not block the calling thread.
+// When built with `ASP_ENABLE_IO_URING` on Linux, requests are submitted to an io_uring, with requests from concurrent callers
+// batched into a single submission. Otherwise, or if io_uring is not available at runtime, they are ran on the blocking
+// thread pool of the runtime (see `spawnBlocking`). Buffers must stay valid until the returned future completes.
+// On Windows, `fd` is a C runtime file descriptor, and the I/O is done on its underlying handle.
+
+// Reads up to `len` bytes at `offset` into `buf`. Resolves with the amount of bytes read, 0 means end of file.
+FutureHandle<size_t> readAt(int fd, void* buf, size_t len, uint64_t offset);
+
+// Writes up to `len` bytes from `buf` at `offset`. Resolves with the amount of bytes written.
+FutureHandle<size_t> writeAt(int fd, const void* buf, size_t len, uint64_t offset);
+
+// Flushes the data and metadata of the file to the storage device.
+FutureHandle<void> fsyncFile(int fd);
+
+// Returns `true` if file I/O goes through io_uring.
+bool usingIoUring();
+
+}
\ No newline at end of file
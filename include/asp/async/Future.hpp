@@ -1,23 +1,136 @@
 #pragma once
 
 #include "Macros.hpp"
+#include "Cancellation.hpp"
+#include "Executor.hpp"
 #include "../config.hpp"
+#include "../sync/Atomic.hpp"
 
+#include <coroutine>
+#include <cstddef>
 #include <functional>
 #include <memory>
-#include <mutex>
-#include <condition_variable>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
 
 namespace asp::async {
 
+template <typename Out>
+class Future;
+
+class RuntimeImpl;
+
 namespace detail {
     void futureFail(const std::exception& e);
+
+    // Returns whether the calling thread is a worker of a thread pool, or drives a runtime in current-thread mode.
+    bool isWorkerThread();
+
+    // If the calling thread is a worker of a thread pool or drives a current-thread runtime, runs one task from its queue.
+    // Returns `false` if nothing was ran.
+    bool runPendingTask();
+
+    // Counts how deeply waits that help with other tasks are nested on the calling thread. A helped task may wait on
+    // another future and help again, so past a fixed depth the scope is not entered and the thread blocks instead.
+    class HelpScope {
+    public:
+        HelpScope();
+        ~HelpScope();
+
+        HelpScope(const HelpScope&) = delete;
+        HelpScope& operator=(const HelpScope&) = delete;
+
+        explicit operator bool() const {
+            return entered;
+        }
+
+    private:
+        bool entered;
+    };
+
+    // Allocator for future objects. Every thread keeps free lists of recently used blocks, so a future that is spawned and
+    // completed over and over reuses the same memory instead of calling into the global allocator.
+    // Blocks freed by another thread are handed back to the thread that allocated them.
+    void* allocateFuture(size_t size);
+    void deallocateFuture(void* ptr);
+
+    // Node of the intrusive list of waiters that get notified once a future completes, for example suspended coroutines.
+    // Nodes are owned by whoever registers them and must stay alive until `onComplete` is called.
+    class FutureWaiter {
+    public:
+        virtual void onComplete() = 0;
+
+    private:
+        template <typename Out>
+        friend class ::asp::async::Future;
+
+        FutureWaiter* next = nullptr;
+    };
+
+    // Waiter that hands a function over to an executor, and then frees itself.
+    class ScheduledWaiter final : public FutureWaiter {
+    public:
+        ScheduledWaiter(Executor& executor, std::function<void()>&& job) : executor(executor), job(std::move(job)) {}
+
+        void onComplete() override {
+            auto& ex = executor;
+            auto j = std::move(job);
+            delete this;
+
+            ex.execute(std::move(j));
+        }
+
+    private:
+        Executor& executor;
+        std::function<void()> job;
+    };
+
+    // Waiter used by `join` on the thread driving a current-thread runtime. That thread may be the only one that can
+    // complete the future, so instead of blocking it keeps running the runtime's tasks until the future completes.
+    class LocalWaiter final : public FutureWaiter {
+    public:
+        // Evaluates to `false` if the calling thread does not drive a current-thread runtime.
+        LocalWaiter();
+
+        LocalWaiter(const LocalWaiter&) = delete;
+        LocalWaiter& operator=(const LocalWaiter&) = delete;
+
+        explicit operator bool() const {
+            return runtime != nullptr;
+        }
+
+        void onComplete() override;
+
+        // Runs queued tasks, or sleeps while there are none, until `onComplete` has been called.
+        void wait();
+
+    private:
+        RuntimeImpl* runtime;
+        // guarded by the local queue mutex of the runtime
+        bool done = false;
+    };
+
+    template <typename F, typename Out>
+    struct ContinuationResult {
+        using type = std::invoke_result_t<F, const Out&>;
+    };
+
+    template <typename F>
+    struct ContinuationResult<F, void> {
+        using type = std::invoke_result_t<F>;
+    };
 }
 
+template <typename FOut>
+class FutureHandle;
+
 // Exception that is thrown when joining a future that ends up throwing.
 class FutureFailed : public std::runtime_error {
 public:
-    FutureFailed(const std::exception& e) : inner(e), runtime_error(e.what()) {}
+    FutureFailed(const std::exception& e) : runtime_error(e.what()), inner(e) {}
 
 private:
     std::exception inner;
@@ -25,190 +138,550 @@ private:
 
 template <typename Out = void>
 class Future {
+    static constexpr bool IsVoid = std::is_void_v<Out>;
+    using OutRef = std::add_lvalue_reference_t<Out>;
+    using Storage = std::conditional_t<IsVoid, std::byte, Out>;
+
 public:
     using Task = std::function<Out()>;
+    using Callback = std::conditional_t<IsVoid, std::function<void()>, std::function<void(const Storage&)>>;
 
-    Future(Task&& func) : task(std::move(func)) {}
-    Future(const Task& func) : task(func) {}
+    // Creates a future without a task, that must be completed by calling `resolve` or `reject`.
+    Future() {}
+    Future(Task&& func) : task(std::move(func)), state(HAS_TASK) {}
+    Future(const Task& func) : task(func), state(HAS_TASK) {}
 
     Future(const Future&) = delete;
     Future& operator=(const Future&) = delete;
 
-    ~Future() {
-        if (finished) {
-            _res().~Out();
-        } else if (failed) {
-            _err().~exception();
+    static void* operator new(size_t size) {
+        return detail::allocateFuture(size);
+    }
+
+    static void operator delete(void* ptr) {
+        detail::deallocateFuture(ptr);
+    }
+
+    // over-aligned results bypass the pool
+    static void* operator new(size_t size, std::align_val_t align) {
+        return ::operator new(size, align);
+    }
+
+    static void operator delete(void* ptr, std::align_val_t align) {
+        ::operator delete(ptr, align);
+    }
+
+    virtual ~Future() {
+        uint32_t st = state.load(std::memory_order::acquire);
+
+        if constexpr (!IsVoid) {
+            if (st & HAS_RESULT) {
+                _res().~Out();
+            }
+        }
+
+        if (st & HAS_ERROR) {
+            _err().~runtime_error();
         }
     }
 
     // Starts the future. Blocks the calling thread.
+    // Does nothing if the future has already been started, for example by a worker thread that awaited it before it was ran.
     void start() {
-        {
-            std::unique_lock lock(mtx);
+        ASP_ALWAYS_ASSERT(state.load() & HAS_TASK, "cannot start an empty Future");
 
-            ASP_ASSERT(!running, "cannot start the same Future twice");
-            ASP_ASSERT(!finished && !failed, "cannot restart a Future that has already finished running");
-            ASP_ALWAYS_ASSERT(task, "cannot start an empty Future");
+        if (!this->transition(PENDING, RUNNING)) return;
 
-            running = true;
+        try {
+            if constexpr (IsVoid) {
+                this->runTask();
+            } else {
+                new (&_ru.resultBuf) Out(this->runTask());
+            }
+        } catch (const std::exception& e) {
+            this->completeError(e);
+            return;
         }
 
-        // this line of code will haunt you in your dreams
-        // *new (&resultBuf) Out = std::move(task());
+        this->completeResult();
+    }
 
-        try {
-            new (&_ru.resultBuf) Out(std::move(task()));
-        } catch (const std::exception& e) {
-            std::unique_lock lock(mtx);
-            running = false;
+    // Records the executor that the task has been queued on, which lets a waiting thread of the same executor start it inline.
+    void setExecutor(Executor& ex) {
+        executor = &ex;
+    }
 
-            new (&_ru.errorBuf) std::exception(e);
+    // Completes a future that has no task with the given value. Must be called at most once, and not together with `reject`.
+    // Does nothing if the future has been cancelled.
+    template <typename... Args>
+    void resolve(Args&&... args) {
+        if (!this->markRunning()) return;
 
-            failed = true;
+        if constexpr (!IsVoid) {
+            new (&_ru.resultBuf) Out(std::forward<Args>(args)...);
+        }
 
-            if (errorHandler) {
-                errorHandler(e);
-            } else {
-                detail::futureFail(e);
-            }
+        this->completeResult();
+    }
 
-            cvar.notify_all();
+    // Fails a future that has no task with the given error. Must be called at most once, and not together with `resolve`.
+    void reject(const std::exception& e) {
+        if (!this->markRunning()) return;
+        this->completeError(e);
+    }
 
-            return;
-        }
+    // Like `reject`, but for errors that come from another future and have already been reported there,
+    // so they are not logged again if no error handler is set.
+    void propagate(const std::exception& e) {
+        if (!this->markRunning()) return;
+        this->completeError(e, false);
+    }
 
-        std::unique_lock lock(mtx);
-        running = false;
-        finished = true;
+    // Cancels the future if it has not started running yet, failing it with a `CancelledError`. Its task will then never run,
+    // and later calls to `resolve` or `reject` are ignored. Returns `false` if the future is already running or has completed.
+    bool cancel() {
+        uint32_t st = state.load(std::memory_order::relaxed);
 
-        if (callback) callback(_res());
+        do {
+            if ((st & STATUS_MASK) != PENDING) return false;
+        } while (!state.compareExchangeWeak(st, (st & ~STATUS_MASK) | RUNNING | CANCELLED, std::memory_order::acq_rel, std::memory_order::relaxed));
 
-        cvar.notify_all();
+        this->completeError(CancelledError{}, false);
+        return true;
+    }
+
+    bool isCancelled() const {
+        return state.load(std::memory_order::acquire) & CANCELLED;
+    }
+
+    // Marks a future that has no task as running, so that it can no longer be cancelled and a later `resolve` is guaranteed to
+    // take effect. Returns `false` if it has already been cancelled or completed. Used to reserve a waiting future under a lock,
+    // and complete it after unlocking.
+    bool claim() {
+        return this->transition(PENDING, RUNNING);
     }
 
     bool isRunning() const {
-        std::unique_lock lock(mtx);
-        return running;
+        return this->status() == RUNNING;
     }
 
     bool hasFinished() const {
-        std::unique_lock lock(mtx);
-        return finished || failed;
+        auto st = this->status();
+        return st == FINISHED || st == FAILED;
     }
 
     bool hasResult() const {
-        std::unique_lock lock(mtx);
-        return finished;
+        return this->status() == FINISHED;
     }
 
     bool hasError() const {
-        std::unique_lock lock(mtx);
-        return failed;
+        return this->status() == FAILED;
     }
 
-    Out& getResult() const {
-        std::unique_lock lock(mtx);
+    OutRef getResult() const requires (!IsVoid) {
+        auto st = this->status();
 
-        ASP_ASSERT(!failed, "cannot get a result of a Future that has failed");
-        ASP_ALWAYS_ASSERT(finished, "cannot get a result of a Future that hasn't yet been finished");
+        ASP_ASSERT(st != FAILED, "cannot get a result of a Future that has failed");
+        ASP_ALWAYS_ASSERT(st == FINISHED, "cannot get a result of a Future that hasn't yet been finished");
 
         return _res();
     }
 
     const std::exception& getError() const {
-        std::unique_lock lock(mtx);
-
-        ASP_ALWAYS_ASSERT(failed, "cannot get an error of a Future that has not failed");
+        ASP_ALWAYS_ASSERT(this->status() == FAILED, "cannot get an error of a Future that has not failed");
 
         return _err();
     }
 
-    Out& await() const {
-        std::unique_lock lock(mtx);
+    OutRef await() const {
+        this->join();
 
-        if (finished) {
-            return _res();
-        } else if (failed) {
+        if (this->status() == FAILED) {
             throw FutureFailed(_err());
         }
 
-        cvar.wait(lock, [this] { return finished || failed; });
-
-        if (failed) {
-            throw FutureFailed(_err());
+        if constexpr (!IsVoid) {
+            return _res();
         }
-
-        return _res();
     }
 
+    // When called from a worker thread of a pool or the thread driving a current-thread runtime, instead of blocking,
+    // runs the future itself if it has not been started yet and was queued on the executor of the calling thread
+    // (see `currentExecutor()`), and helps with other tasks from the queue of the calling thread until it completes.
+    // The thread driving a current-thread runtime keeps running tasks as they are queued, until the future completes.
+    // Otherwise blocks the calling thread.
     void join() const {
-        std::unique_lock lock(mtx);
+        uint32_t st = state.load(std::memory_order::acquire);
 
-        if (finished || failed) {
-            return;
+        if (!isFinal(st) && detail::isWorkerThread()) {
+            detail::HelpScope scope;
+
+            if (scope) {
+                // a future queued elsewhere, for example on another runtime or the blocking pool, must stay there
+                if ((st & STATUS_MASK) == PENDING && (st & HAS_TASK) && executor && executor == &currentExecutor()) {
+                    // futures are always heap allocated and never actually const
+                    const_cast<Future*>(this)->start();
+                }
+
+                while (!isFinal(st = state.load(std::memory_order::acquire)) && detail::runPendingTask()) {}
+
+                // a current-thread runtime has nobody else to run its tasks, so keep running them as they get queued
+                if (detail::LocalWaiter waiter; !isFinal(st) && waiter && this->addWaiter(&waiter)) {
+                    waiter.wait();
+                    st = state.load(std::memory_order::acquire);
+                }
+            }
         }
 
-        cvar.wait(lock, [this] { return finished || failed; });
+        while (!isFinal(st)) {
+            state.wait(st, std::memory_order::acquire);
+            st = state.load(std::memory_order::acquire);
+        }
     }
 
-    void then(std::function<void(const Out&)>&& f) const {
-        std::unique_lock lock(mtx);
+    void then(Callback&& f) const {
+        uint32_t st = this->lockState();
+
+        if (st & HAS_RESULT) {
+            this->unlockState();
+
+            if constexpr (IsVoid) {
+                f();
+            } else {
+                f(_res());
+            }
 
-        if (finished) {
-            f(_res());
-        } else if (failed) {
             return;
+        } else if (st & HAS_ERROR) {
+            this->unlockState();
+            return;
+        }
+
+        if (callback) {
+            callback = [first = std::move(callback), second = std::move(f)](const auto&... args) {
+                first(args...);
+                second(args...);
+            };
+        } else {
+            callback = std::move(f);
         }
 
-        callback = std::move(f);
+        this->unlockState();
     }
 
     void expect(std::function<void(const std::exception&)>&& f) const {
-        std::unique_lock lock(mtx);
+        uint32_t st = this->lockState();
 
-        if (finished) {
+        if (st & HAS_RESULT) {
+            this->unlockState();
             return;
-        } else if (failed) {
+        } else if (st & HAS_ERROR) {
+            this->unlockState();
             f(_err());
+            return;
         }
 
-        errorHandler = std::move(f);
+        if (errorHandler) {
+            errorHandler = [first = std::move(errorHandler), second = std::move(f)](const std::exception& e) {
+                first(e);
+                second(e);
+            };
+        } else {
+            errorHandler = std::move(f);
+        }
+
+        this->unlockState();
+    }
+
+    // Registers a waiter that will be notified after the future finishes or fails, on the thread that completed it.
+    // Returns `false` without registering if the future has already finished or failed.
+    bool addWaiter(detail::FutureWaiter* waiter) const {
+        uint32_t st = this->lockState();
+
+        if (isFinal(st)) {
+            this->unlockState();
+            return false;
+        }
+
+        waiter->next = waiters;
+        waiters = waiter;
+
+        this->unlockState();
+        return true;
+    }
+
+    // Futures are reference counted, see `detail::FutureRef`. The future is destroyed when the last reference is released.
+    void addRef() const {
+        refs.fetchAdd(1, std::memory_order::relaxed);
+    }
+
+    void release() const {
+        if (refs.fetchSub(1, std::memory_order::acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+protected:
+    struct WithTask {};
+
+    // Used by subclasses that store the task themselves and override `runTask`.
+    Future(WithTask) : state(HAS_TASK) {}
+
+    virtual Out runTask() {
+        return task();
     }
 
 private:
+    // Layout of the state word. The lowest 2 bits hold the status, the rest are flags.
+    // `LOCKED` is a tiny spinlock that only guards the callbacks, it is never held while running user code.
+    // `HAS_RESULT` and `HAS_ERROR` are set once the value is stored, which happens before the status changes to finished or failed.
+    static constexpr uint32_t PENDING = 0;
+    static constexpr uint32_t RUNNING = 1;
+    static constexpr uint32_t FINISHED = 2;
+    static constexpr uint32_t FAILED = 3;
+    static constexpr uint32_t STATUS_MASK = 0b11;
+    static constexpr uint32_t LOCKED = 1 << 2;
+    static constexpr uint32_t HAS_RESULT = 1 << 3;
+    static constexpr uint32_t HAS_ERROR = 1 << 4;
+    static constexpr uint32_t HAS_TASK = 1 << 5;
+    static constexpr uint32_t CANCELLED = 1 << 6;
+
     Task task;
-    mutable std::mutex mtx;
-    mutable std::condition_variable cvar;
-    mutable std::function<void(const Out&)> callback;
+    Executor* executor = nullptr;
     mutable std::function<void(const std::exception&)> errorHandler;
-    bool running = false, finished = false, failed = false;
+    mutable Callback callback;
+    mutable detail::FutureWaiter* waiters = nullptr;
+    mutable sync::AtomicU32 state = PENDING;
+    mutable sync::AtomicU32 refs = 0;
 
     mutable union {
-        alignas(Out) std::byte resultBuf[sizeof(Out)];
-        alignas(std::exception) std::byte errorBuf[sizeof(std::exception)];
+        alignas(Storage) std::byte resultBuf[sizeof(Storage)];
+        alignas(std::runtime_error) std::byte errorBuf[sizeof(std::runtime_error)];
     } _ru;
 
-    Out& _res() const {
-        ASP_ASSERT(finished, "Future::_res called on a future that hasn't finished successfully");
+    static bool isFinal(uint32_t st) {
+        return (st & STATUS_MASK) >= FINISHED;
+    }
+
+    uint32_t status() const {
+        return state.load(std::memory_order::acquire) & STATUS_MASK;
+    }
+
+    // Changes the status from `from` to `to`, keeping the flags intact. Returns `false` if the status was not `from`.
+    bool transition(uint32_t from, uint32_t to) {
+        uint32_t st = state.load(std::memory_order::relaxed);
+
+        while ((st & STATUS_MASK) == from) {
+            if (state.compareExchangeWeak(st, (st & ~STATUS_MASK) | to, std::memory_order::acq_rel, std::memory_order::relaxed)) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Returns `false` if the future has been cancelled, and should not be completed.
+    bool markRunning() {
+        if (this->transition(PENDING, RUNNING)) return true;
+
+        uint32_t st = state.load(std::memory_order::acquire);
+        if (st & CANCELLED) return false;
+
+        ASP_ALWAYS_ASSERT((st & STATUS_MASK) == RUNNING, "cannot complete a Future that has already completed");
+        return true;
+    }
+
+    // Called once the result has been stored. Runs the callbacks, publishes the status and wakes up everyone waiting.
+    void completeResult() {
+        this->lockState();
+        auto cb = std::move(callback);
+        this->unlockState(HAS_RESULT);
+
+        if (cb) {
+            if constexpr (IsVoid) {
+                cb();
+            } else {
+                cb(_res());
+            }
+        }
+
+        this->publish(FINISHED);
+    }
+
+    void completeError(const std::exception& e, bool report = true) {
+        new (&_ru.errorBuf) std::runtime_error(e.what());
+
+        this->lockState();
+        auto handler = std::move(errorHandler);
+        this->unlockState(HAS_ERROR);
+
+        if (handler) {
+            handler(e);
+        } else if (report) {
+            detail::futureFail(e);
+        }
+
+        this->publish(FAILED);
+    }
+
+    // Sets the final status and wakes up everyone waiting. Waiters are taken together with the status change,
+    // so that ones registered by callbacks are not lost, and ones registered afterwards see the final status.
+    void publish(uint32_t status) {
+        this->lockState();
+        auto w = std::exchange(waiters, nullptr);
+        this->transition(RUNNING, status);
+        this->unlockState();
+
+        state.notifyAll();
+
+        notifyWaiters(w);
+    }
+
+    // Waiters are pushed to the front of the list, so reverse it to notify them in the order they were registered.
+    // The future itself may be destroyed by a waiter, so this must not touch any members.
+    static void notifyWaiters(detail::FutureWaiter* w) {
+        detail::FutureWaiter* ordered = nullptr;
+
+        while (w) {
+            auto next = w->next;
+            w->next = ordered;
+            ordered = w;
+            w = next;
+        }
+
+        while (ordered) {
+            auto next = ordered->next;
+            ordered->onComplete();
+            ordered = next;
+        }
+    }
+
+    // Acquires the callback lock and returns the state word as it was at the moment of locking.
+    uint32_t lockState() const {
+        uint32_t st = state.load(std::memory_order::relaxed);
+
+        while (true) {
+            if (st & LOCKED) {
+                std::this_thread::yield();
+                st = state.load(std::memory_order::relaxed);
+            } else if (state.compareExchangeWeak(st, st | LOCKED, std::memory_order::acquire, std::memory_order::relaxed)) {
+                return st;
+            }
+        }
+    }
+
+    // Releases the callback lock, optionally setting flags (that must not be set yet) at the same time.
+    void unlockState(uint32_t flags = 0) const {
+        state.fetchXor(LOCKED | flags, std::memory_order::release);
+    }
+
+    OutRef _res() const requires (!IsVoid) {
+        ASP_ASSERT(state.load() & HAS_RESULT, "Future::_res called on a future that hasn't finished successfully");
 
         Out* ptr = std::launder(reinterpret_cast<Out*>(&_ru.resultBuf));
         return *ptr;
     }
 
-    const std::exception& _err() const {
-        ASP_ASSERT(failed, "Future::_err called on a future that hasn't failed");
-
-        std::exception* ptr = std::launder(reinterpret_cast<std::exception*>(&_ru.errorBuf));
+    std::runtime_error& _err() const {
+        ASP_ASSERT(state.load() & HAS_ERROR, "Future::_err called on a future that hasn't failed");
 
+        std::runtime_error* ptr = std::launder(reinterpret_cast<std::runtime_error*>(&_ru.errorBuf));
         return *ptr;
     }
 };
 
+namespace detail {
+    // Owning reference to a future, like a `std::shared_ptr` but with the counter stored inside of the future.
+    template <typename Out>
+    class FutureRef {
+    public:
+        FutureRef() : ptr(nullptr) {}
+
+        explicit FutureRef(Future<Out>* ptr) : ptr(ptr) {
+            if (ptr) ptr->addRef();
+        }
+
+        FutureRef(const FutureRef& other) : ptr(other.ptr) {
+            if (ptr) ptr->addRef();
+        }
+
+        FutureRef(FutureRef&& other) noexcept : ptr(std::exchange(other.ptr, nullptr)) {}
+
+        FutureRef& operator=(const FutureRef& other) {
+            if (this != &other) {
+                FutureRef(other).swap(*this);
+            }
+
+            return *this;
+        }
+
+        FutureRef& operator=(FutureRef&& other) noexcept {
+            if (this != &other) {
+                FutureRef(std::move(other)).swap(*this);
+            }
+
+            return *this;
+        }
+
+        ~FutureRef() {
+            if (ptr) ptr->release();
+        }
+
+        void swap(FutureRef& other) noexcept {
+            std::swap(ptr, other.ptr);
+        }
+
+        Future<Out>* get() const {
+            return ptr;
+        }
+
+        Future<Out>* operator->() const {
+            return ptr;
+        }
+
+        Future<Out>& operator*() const {
+            return *ptr;
+        }
+
+        explicit operator bool() const {
+            return ptr != nullptr;
+        }
+
+    private:
+        Future<Out>* ptr;
+    };
+
+    // Creates a future without a task, to be completed with `resolve` or `reject`.
+    template <typename Out>
+    FutureRef<Out> makeFuture() {
+        return FutureRef<Out>(new Future<Out>());
+    }
+
+    // Future that stores the task inline instead of in a `std::function`, so that spawning it takes a single allocation.
+    template <typename Out, typename F>
+    class SpawnedFuture final : public Future<Out> {
+    public:
+        template <typename Fn>
+        SpawnedFuture(Fn&& func) : Future<Out>(typename Future<Out>::WithTask{}), func(std::forward<Fn>(func)) {}
+
+    protected:
+        Out runTask() override {
+            return func();
+        }
+
+    private:
+        F func;
+    };
+}
+
 template <typename FOut = void>
 class FutureHandle {
+    using OutRef = std::add_lvalue_reference_t<FOut>;
+
 public:
-    FutureHandle(std::shared_ptr<Future<FOut>> fut) : fut(std::move(fut)) {}
+    using Output = FOut;
+
+    FutureHandle(detail::FutureRef<FOut> fut) : fut(std::move(fut)) {}
 
     // Returns whether the future is currently running.
     bool isRunning() const {
@@ -230,8 +703,34 @@ public:
         return fut->hasError();
     }
 
+    // Cancels the future if it has not started running yet, it then fails with a `CancelledError` and its task never runs.
+    // Continuations created with `map`, `andThen` or `orElse` are cancelled as well. Returns `false` if it was too late to cancel.
+    bool cancel() const {
+        return fut->cancel();
+    }
+
+    bool isCancelled() const {
+        return fut->isCancelled();
+    }
+
+    // Cancels the future once the token is cancelled.
+    const FutureHandle& cancelWith(const CancellationToken& token) const {
+        auto id = token.onCancel([fut = fut] {
+            fut->cancel();
+        });
+
+        if (id != 0) {
+            // unregister once the future completes, so that the token does not keep it alive
+            this->onComplete(InlineExecutor::get(), [token, id] {
+                token.removeCallback(id);
+            });
+        }
+
+        return *this;
+    }
+
     // Gets the result of the future, if it has finished. If it has not, throws an exception.
-    FOut& getResult() const {
+    OutRef getResult() const requires (!std::is_void_v<FOut>) {
         return fut->getResult();
     }
 
@@ -241,7 +740,7 @@ public:
     }
 
     // Blocks until the future is complete and then returns a reference to the return value.
-    FOut& await() const {
+    OutRef await() const {
         return fut->await();
     }
 
@@ -250,216 +749,233 @@ public:
         return fut->join();
     }
 
-    // Schedule a callback to be called when the future completes execution.
+    // Schedule a callback to be called when the future completes execution, on the thread that completes it.
     // The callback will always be ran strictly *before* notifying any awaiters.
+    // Multiple callbacks can be added, they are called in the order they were added.
     // If the future has already successfully finished execution, the callback is invoked immediately.
-    FutureHandle& then(std::function<void(const FOut&)>&& f) {
+    FutureHandle& then(typename Future<FOut>::Callback&& f) {
         fut->then(std::move(f));
         return *this;
     }
 
+    // Like `then`, but the callback is scheduled on the given executor after the future has successfully finished.
+    FutureHandle& then(typename Future<FOut>::Callback&& f, Executor& executor) {
+        this->onComplete(executor, [fut = fut, f = std::move(f)] {
+            if (!fut->hasResult()) return;
+
+            if constexpr (std::is_void_v<FOut>) {
+                f();
+            } else {
+                f(fut->getResult());
+            }
+        });
+
+        return *this;
+    }
+
     // Sets the function that will be called if the future throws an exception.
     // When not set, by default the exception message will simply be logged.
+    // Multiple functions can be added, they are called in the order they were added.
     // If the future has already finished execution and ended up throwing an exception, the callback is invoked immediately.
     FutureHandle& expect(std::function<void(const std::exception&)>&& f) {
         fut->expect(std::move(f));
         return *this;
     }
 
-private:
-    std::shared_ptr<Future<FOut>> fut;
-};
-
-/* Specialization for void futures */
-
-template <>
-class Future<void> {
-public:
-    using Task = std::function<void()>;
-
-    Future(Task&& func) : task(std::move(func)) {}
-    Future(const Task& func) : task(func) {}
-
-    Future(const Future&) = delete;
-    Future& operator=(const Future&) = delete;
-
-    void start() {
-        {
-            std::unique_lock lock(mtx);
-
-            ASP_ASSERT(!running, "cannot start the same Future twice");
-            ASP_ASSERT(!finished, "cannot restart a Future that was already finished");
-            ASP_ALWAYS_ASSERT(task, "cannot start an empty Future");
+    // Schedules `f` on the given executor once the future has either finished or failed.
+    // Continuations run on the executor of the calling thread by default, see `currentExecutor()`.
+    const FutureHandle& finally(std::function<void()>&& f, Executor& executor = currentExecutor()) const {
+        this->onComplete(executor, std::move(f));
+        return *this;
+    }
 
-            running = true;
-        }
-        try {
-            task();
-        } catch (const std::exception& e) {
-            std::unique_lock lock(mtx);
-            running = false;
-            error = e;
-            failed = true;
+    // Returns a new future that completes with `func(result)` once this future finishes, or fails with the same error.
+    // `func` runs on the given executor, pass `InlineExecutor::get()` to run it on the thread that completed this future.
+    template <typename F, typename R = typename detail::ContinuationResult<F, FOut>::type>
+    FutureHandle<R> map(F&& func, Executor& executor = currentExecutor()) const {
+        auto child = detail::makeFuture<R>();
 
-            if (errorHandler) {
-                errorHandler(e);
-            } else {
-                detail::futureFail(e);
+        this->onComplete(executor, [parent = fut, child, func = std::forward<F>(func)]() mutable {
+            if (parent->isCancelled()) {
+                child->cancel();
+                return;
+            } else if (parent->hasError()) {
+                child->propagate(parent->getError());
+                return;
             }
 
-            cvar.notify_all();
-
-            return;
-        }
-
-        std::unique_lock lock(mtx);
-        running = false;
-        finished = true;
-
-        if (callback) callback();
+            try {
+                if constexpr (std::is_void_v<R>) {
+                    invokeWithResult(func, *parent);
+                    child->resolve();
+                } else {
+                    child->resolve(invokeWithResult(func, *parent));
+                }
+            } catch (const std::exception& e) {
+                child->reject(e);
+            }
+        });
+
+        return FutureHandle<R>(std::move(child));
+    }
+
+    // Like `map`, but `func` itself returns a `FutureHandle`, and the returned future completes once that one does.
+    template <
+        typename F,
+        typename Inner = typename detail::ContinuationResult<F, FOut>::type,
+        typename R = typename Inner::Output
+    >
+    FutureHandle<R> andThen(F&& func, Executor& executor = currentExecutor()) const {
+        auto child = detail::makeFuture<R>();
+
+        this->onComplete(executor, [parent = fut, child, func = std::forward<F>(func)]() mutable {
+            if (parent->isCancelled()) {
+                child->cancel();
+                return;
+            } else if (parent->hasError()) {
+                child->propagate(parent->getError());
+                return;
+            }
 
-        cvar.notify_all();
-    }
+            try {
+                Inner inner = invokeWithResult(func, *parent);
+                inner.forwardTo(child);
+            } catch (const std::exception& e) {
+                child->reject(e);
+            }
+        });
 
-    bool isRunning() const {
-        std::unique_lock lock(mtx);
-        return running;
+        return FutureHandle<R>(std::move(child));
     }
 
-    bool hasFinished() const {
-        std::unique_lock lock(mtx);
-        return finished || failed;
-    }
+    // Returns a new future that completes with the same value as this one, or, if this one fails, with `func(error)`.
+    template <typename F>
+    FutureHandle<FOut> orElse(F&& func, Executor& executor = currentExecutor()) const {
+        auto child = detail::makeFuture<FOut>();
 
-    bool hasResult() const {
-        std::unique_lock lock(mtx);
-        return finished;
-    }
+        this->onComplete(executor, [parent = fut, child, func = std::forward<F>(func)]() mutable {
+            if (parent->isCancelled()) {
+                child->cancel();
+                return;
+            } else if (parent->hasResult()) {
+                if constexpr (std::is_void_v<FOut>) {
+                    child->resolve();
+                } else {
+                    child->resolve(parent->getResult());
+                }
 
-    bool hasError() const {
-        std::unique_lock lock(mtx);
-        return failed;
-    }
+                return;
+            }
 
-    const std::exception& getError() const {
-        std::unique_lock lock(mtx);
+            try {
+                if constexpr (std::is_void_v<FOut>) {
+                    func(parent->getError());
+                    child->resolve();
+                } else {
+                    child->resolve(func(parent->getError()));
+                }
+            } catch (const std::exception& e) {
+                child->reject(e);
+            }
+        });
 
-        ASP_ALWAYS_ASSERT(failed, "cannot get an error of a Future that has not failed");
+        return FutureHandle<FOut>(std::move(child));
+    }
 
-        return _err();
+    // Allows `co_await handle` inside of coroutines. Instead of blocking, the coroutine is suspended and then resumed
+    // by the thread that completes the future. Like `await()`, throws `FutureFailed` if the future failed.
+    auto operator co_await() const {
+        return Awaiter(fut);
     }
 
-    void await() const {
-        std::unique_lock lock(mtx);
+private:
+    template <typename>
+    friend class FutureHandle;
 
-        if (finished) {
-            return;
-        } else if (failed) {
-            throw FutureFailed(_err());
-        }
+    detail::FutureRef<FOut> fut;
 
-        cvar.wait(lock, [this] { return finished || failed; });
+    // Runs `job` on the executor once the future has finished or failed, or right away if it already did.
+    void onComplete(Executor& executor, std::function<void()>&& job) const {
+        auto waiter = new detail::ScheduledWaiter(executor, std::move(job));
 
-        if (failed) {
-            throw FutureFailed(_err());
+        if (!fut->addWaiter(waiter)) {
+            waiter->onComplete();
         }
     }
 
-    void join() const {
-        std::unique_lock lock(mtx);
-
-        if (finished || failed) {
-            return;
-        }
-
-        cvar.wait(lock, [this] { return finished || failed; });
+    // Completes `target` with the outcome of this future, once it is known.
+    void forwardTo(const detail::FutureRef<FOut>& target) const {
+        this->onComplete(InlineExecutor::get(), [source = fut, target] {
+            if (source->hasError()) {
+                target->propagate(source->getError());
+            } else if constexpr (std::is_void_v<FOut>) {
+                target->resolve();
+            } else {
+                target->resolve(source->getResult());
+            }
+        });
     }
 
-    void then(std::function<void()>&& f) const {
-        std::unique_lock lock(mtx);
-
-        if (finished) {
-            f();
-        } else if (failed) {
-            return;
+    template <typename F>
+    static decltype(auto) invokeWithResult(F& func, Future<FOut>& source) {
+        if constexpr (std::is_void_v<FOut>) {
+            return func();
+        } else {
+            return func(source.getResult());
         }
-
-        callback = std::move(f);
     }
 
-    void expect(std::function<void(const std::exception&)>&& f) const {
-        std::unique_lock lock(mtx);
+    class Awaiter : public detail::FutureWaiter {
+    public:
+        Awaiter(detail::FutureRef<FOut> fut) : fut(std::move(fut)) {}
 
-        if (finished) {
-            return;
-        } else if (failed) {
-            f(_err());
+        bool await_ready() const {
+            return fut->hasFinished();
         }
 
-        errorHandler = std::move(f);
-    }
+        bool await_suspend(std::coroutine_handle<> h) {
+            this->handle = h;
+            return fut->addWaiter(this);
+        }
 
-private:
-    Task task;
-    mutable std::mutex mtx;
-    mutable std::condition_variable cvar;
-    mutable std::function<void()> callback;
-    mutable std::function<void(const std::exception&)> errorHandler;
-    bool running = false, finished = false, failed = false;
-    std::exception error;
+        OutRef await_resume() const {
+            return fut->await();
+        }
 
-    const std::exception& _err() const {
-        ASP_ASSERT(failed, "Future::_err called on a future that hasn't failed");
+        void onComplete() override {
+            handle.resume();
+        }
 
-        return error;
-    }
+    private:
+        detail::FutureRef<FOut> fut;
+        std::coroutine_handle<> handle;
+    };
 };
 
-template <>
-class FutureHandle<void> {
+// The producing side of a future that is completed manually rather than by running a task.
+template <typename T = void>
+class Promise {
 public:
-    FutureHandle(std::shared_ptr<Future<void>> fut) : fut(std::move(fut)) {}
-
-    bool isRunning() const {
-        return fut->isRunning();
-    }
-
-    bool hasFinished() const {
-        return fut->hasFinished();
-    }
-
-    bool hasResult() const {
-        return fut->hasResult();
-    }
+    Promise() : fut(detail::makeFuture<T>()) {}
 
-    bool hasError() const {
-        return fut->hasError();
-    }
-
-    const std::exception& getError() const {
-        return fut->getError();
-    }
-
-    void await() const {
-        return fut->await();
+    // Returns a handle to the future that will be completed by this promise.
+    FutureHandle<T> getFuture() const {
+        return FutureHandle<T>(fut);
     }
 
-    void join() const {
-        return fut->join();
+    // Completes the future with the given value. Must be called at most once, and not together with `reject`.
+    template <typename... Args>
+    void resolve(Args&&... args) const {
+        fut->resolve(std::forward<Args>(args)...);
     }
 
-    FutureHandle& then(std::function<void()>&& f) {
-        fut->then(std::move(f));
-        return *this;
-    }
-
-    FutureHandle& expect(std::function<void(const std::exception&)>&& f) {
-        fut->expect(std::move(f));
-        return *this;
+    // Fails the future with the given error. Must be called at most once, and not together with `resolve`.
+    void reject(const std::exception& e) const {
+        fut->reject(e);
     }
 
 private:
-    std::shared_ptr<Future<void>> fut;
+    detail::FutureRef<T> fut;
 };
 
 }
\ No newline at end of file
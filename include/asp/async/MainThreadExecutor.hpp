@@ -0,0 +1,69 @@
+#pragma once
+
+#include "../config.hpp"
+#include "../sync/CachePadded.hpp"
+#include "Executor.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+namespace asp::async {
+
+// Executor whose functions are ran by one thread, typically the main thread of a game loop, whenever it calls `drain()`.
+// Functions can be posted from any thread without locking, posting is a single atomic exchange.
+//
+// ```
+// handle.then([](int result) { applyResult(result); }, MainThreadExecutor::get());
+//
+// // once per frame
+// MainThreadExecutor::get().drain(std::chrono::milliseconds(2));
+// ```
+class MainThreadExecutor : public Executor {
+public:
+    // Returns the global instance, which is never destroyed, so functions still queued at exit are neither ran nor freed.
+    static MainThreadExecutor& get();
+
+    MainThreadExecutor();
+    // Functions that were never drained are destroyed without being ran.
+    ~MainThreadExecutor();
+
+    MainThreadExecutor(const MainThreadExecutor&) = delete;
+    MainThreadExecutor& operator=(const MainThreadExecutor&) = delete;
+
+    // Queues the function to be ran by the next `drain()`. Can be called from any thread.
+    void post(std::function<void()>&& f);
+
+    void execute(std::function<void()>&& f) override {
+        this->post(std::move(f));
+    }
+
+    // Runs queued functions in the order they were posted, until the queue is empty. Returns the amount of functions ran.
+    // Draining must only ever happen on one thread at a time, functions posted while draining are ran as well.
+    size_t drain();
+
+    // Like `drain()`, but runs at most `maxTasks` functions, leaving the rest for the next call.
+    size_t drain(size_t maxTasks);
+
+    // Like `drain()`, but stops once `budget` has elapsed. At least one function is ran if any are queued.
+    size_t drain(std::chrono::nanoseconds budget);
+
+    // Returns whether there is nothing to drain. Must be called from the draining thread.
+    bool empty() const;
+
+private:
+    struct Node {
+        std::atomic<Node*> next = nullptr;
+        std::function<void()> job;
+    };
+
+    // Vyukov's MPSC queue: producers swap themselves in at the head, the consumer follows `next` links from the tail.
+    // The tail always points to an already consumed node, initially a dummy one.
+    sync::CachePadded<std::atomic<Node*>> head;
+    sync::CachePadded<Node*> tail;
+
+    bool pop(std::function<void()>& out);
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../config.hpp"
+#include "Future.hpp"
+
+#ifdef __linux__
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <sys/socket.h>
+
+namespace asp::async {
+
+class ReactorImpl;
+
+// Waits for file descriptors to become ready using epoll on a dedicated thread, so that no worker thread is blocked while waiting.
+// All file descriptors passed to it, or to the `async*` I/O functions, must be in non-blocking mode.
+class Reactor {
+public:
+    enum class Interest {
+        Read,
+        Write,
+    };
+
+    static Reactor& get();
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    ~Reactor();
+
+    // Called with `cancelled` set to `true` if the descriptor was deregistered before it became ready.
+    using Callback = std::function<void(bool cancelled)>;
+
+    // Calls `callback` on the reactor thread once `fd` is ready for the given interest, or has an error or hangup.
+    // The callback is called once and must not block, it is meant to hand off the actual work to an executor.
+    void waitFor(int fd, Interest interest, Callback&& callback);
+
+    // Returns a future that completes once `fd` is ready for the given interest, or fails with `ECANCELED` if it is deregistered.
+    FutureHandle<void> ready(int fd, Interest interest);
+
+    // Stops watching `fd`, pending callbacks are called right away as cancelled, so pending `async*` operations fail with
+    // `ECANCELED` without touching the descriptor again. Must be called before closing a file descriptor that has been waited on,
+    // as epoll would otherwise keep reporting events for a reused descriptor number.
+    void deregister(int fd);
+
+private:
+    std::unique_ptr<ReactorImpl> impl;
+
+    Reactor();
+};
+
+// The following functions retry and complete on the executor of the calling thread, see `currentExecutor()`.
+
+// Reads up to `len` bytes into `buf`, waiting until `fd` is readable. Resolves with the amount of bytes read, 0 means end of file.
+// `buf` must stay valid until the future completes.
+FutureHandle<size_t> asyncRead(int fd, void* buf, size_t len);
+
+// Writes up to `len` bytes from `buf`, waiting until `fd` is writable. Resolves with the amount of bytes written.
+// `buf` must stay valid until the future completes.
+FutureHandle<size_t> asyncWrite(int fd, const void* buf, size_t len);
+
+// Accepts a connection on the listening socket `fd`. Resolves with the new socket, which is already in non-blocking mode.
+FutureHandle<int> asyncAccept(int fd);
+
+// Connects the socket `fd` to the given address, resolves once the connection is established.
+FutureHandle<void> asyncConnect(int fd, const sockaddr* addr, socklen_t addrlen);
+
+}
+
+#endif
\ No newline at end of file
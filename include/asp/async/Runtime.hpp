@@ -1,24 +1,81 @@
 #pragma once
 
 #include "../config.hpp"
+#include "Executor.hpp"
 #include "Future.hpp"
+#include "Task.hpp"
+#include "../thread/ThreadPool.hpp"
 
+#include <chrono>
 #include <memory>
+#include <string_view>
 #include <type_traits>
 
 namespace asp::async {
 
 class RuntimeImpl;
 
+namespace detail {
+    // Returns whether the calling thread has launched a runtime in current-thread mode.
+    bool ownsCurrentThreadRuntime();
+
+    // Runs one task queued on the current-thread runtime owned by the calling thread. Returns `false` if nothing was ran.
+    bool runCurrentThreadTask();
+
+    // Queues the future to be started on the executor, and returns a handle to it.
+    template <typename FOut>
+    FutureHandle<FOut> scheduleFuture(Executor& executor, Future<FOut>* fut, const CancellationToken* token = nullptr) {
+        FutureHandle<FOut> handle(FutureRef<FOut>{fut});
+
+        // a task that is cancelled while still queued is skipped when it is dequeued, as `start` does nothing on a completed future
+        if (token) {
+            handle.cancelWith(*token);
+        }
+
+        // the queued function owns a reference, and captures only a raw pointer so that it fits in `std::function` without allocating
+        fut->addRef();
+        fut->setExecutor(executor);
+        executor.execute([fut] {
+            fut->start();
+            fut->release();
+        });
+
+        return handle;
+    }
+}
+
 struct RuntimeSettings {
     // 0 - auto, 1 - single threaded
     size_t threadCount;
+    // If enabled, the runtime is launched on the first spawned task, rather than requiring a call to `launch()`.
+    bool autoLaunch = false;
+    // Upper bound of threads used by `spawnBlocking`, these are created on demand.
+    size_t maxBlockingThreads = 512;
+    // How long a blocking thread can stay idle before it exits.
+    std::chrono::milliseconds blockingIdleTimeout = std::chrono::seconds(10);
+    // If enabled, no worker threads are created and `threadCount` is ignored. Spawned tasks are queued and ran
+    // by the thread that launched the runtime, whenever it calls `runUntilIdle()` or `blockOn()`. When launched by
+    // `autoLaunch` instead, the tasks belong to the first thread that calls one of those.
+    bool currentThread = false;
 };
 
-class Runtime {
+// Pool of worker threads that futures and coroutines are ran on.
+// Besides the global runtime returned by `get()`, independent runtimes can be created, either directly or by name with `named()`,
+// so that for example blocking work does not take up the workers used for networking.
+class Runtime : public Executor {
 public:
+    // Returns the global runtime, used by the free `spawn` functions and as the default executor for continuations.
     static Runtime& get();
 
+    // Returns the runtime with the given name, creating it if it does not exist yet.
+    // A newly created runtime must be configured and launched like the global one.
+    static Runtime& named(std::string_view name);
+
+    // Creates an independent runtime with its own worker threads. It must be launched before use, unless `autoLaunch` is set.
+    // The destructor waits for all queued tasks to finish.
+    explicit Runtime(const RuntimeSettings& settings);
+    ~Runtime();
+
     Runtime(const Runtime&) = delete;
     Runtime& operator=(const Runtime&) = delete;
     Runtime(Runtime&&) = delete;
@@ -30,24 +87,83 @@ public:
     // Asynchronously launches the runtime, without blocking the calling thread.
     void launch();
 
+    // Schedules the function to be ran on one of the worker threads.
+    void execute(std::function<void()>&& f) override;
+
     // Spawns a future in a different thread, returns a handle that allows you to see the progress of the execution.
     template <typename F, typename FOut = typename std::invoke_result_t<F>>
     FutureHandle<FOut> spawn(F&& func) {
-        auto fut = std::make_shared<Future<FOut>>(std::move(func));
-        this->runAsync([fut] {
-            fut->start();
-        });
-        return FutureHandle<FOut>(std::move(fut));
+        return detail::scheduleFuture<FOut>(*this, new detail::SpawnedFuture<FOut, std::decay_t<F>>(std::forward<F>(func)));
     }
 
     // Spawns a future in a different thread, returns a handle that allows you to see the progress of the execution.
     template <typename F, typename FOut = typename std::invoke_result_t<F>>
     FutureHandle<FOut> spawn(const F& func) {
-        auto fut = std::make_shared<Future<FOut>>(func);
-        this->runAsync([fut] {
-            fut->start();
+        return detail::scheduleFuture<FOut>(*this, new detail::SpawnedFuture<FOut, std::decay_t<F>>(func));
+    }
+
+    // Like `spawn`, but the future is cancelled when the token is, if it has not started running by then.
+    // A running task can poll the token itself to stop early.
+    template <typename F, typename FOut = typename std::invoke_result_t<F>>
+    FutureHandle<FOut> spawn(const CancellationToken& token, F&& func) {
+        return detail::scheduleFuture<FOut>(*this, new detail::SpawnedFuture<FOut, std::decay_t<F>>(std::forward<F>(func)), &token);
+    }
+
+    // Spawns a future that is allowed to block, for example on file I/O, and returns a handle to it.
+    // It is ran on a separate pool of threads that grows as needed, so that it does not take up the worker threads.
+    template <typename F, typename FOut = typename std::invoke_result_t<F>>
+    FutureHandle<FOut> spawnBlocking(F&& func) {
+        return detail::scheduleFuture<FOut>(this->blockingExecutor(), new detail::SpawnedFuture<FOut, std::decay_t<F>>(std::forward<F>(func)));
+    }
+
+    // Returns the executor that runs functions on the blocking thread pool, see `spawnBlocking`.
+    Executor& blockingExecutor();
+
+    // Starts a watchdog that reports tasks which block a worker thread for longer than the budget, see `ThreadPool::enableWatchdog`.
+    // The runtime must already be launched.
+    void enableWatchdog(thread::WatchdogSettings settings);
+    void disableWatchdog();
+
+    // Returns the amount of tasks reported by the watchdog so far.
+    uint64_t stallCount() const;
+
+    // Runs queued tasks on the calling thread until the queue is empty, including ones queued by those tasks.
+    // Only for runtimes in current-thread mode, and must be called from the thread that owns the runtime, see `currentThread`.
+    // Returns the amount of tasks that were ran.
+    size_t runUntilIdle();
+
+    // Runs queued tasks on the calling thread until the future completes, then returns its result like `await()`.
+    // While the queue is empty, sleeps until either a task is queued by another thread or the future completes.
+    // Only for runtimes in current-thread mode, and must be called from the thread that owns the runtime, see `currentThread`.
+    template <typename T>
+    decltype(auto) blockOn(const FutureHandle<T>& handle) {
+        // set by the completing thread under the queue lock, unlike `hasFinished()` which becomes true before the closure
+        // runs, so this cannot return and let the runtime be destroyed while the completing thread is still waking it up
+        bool done = false;
+
+        handle.finally([this, &done] {
+            this->wakeLocal(done);
+        }, InlineExecutor::get());
+
+        this->runLocalUntil([&] {
+            return done;
         });
-        return FutureHandle<FOut>(std::move(fut));
+
+        return handle.await();
+    }
+
+    // Runs the coroutine on the runtime, returns a handle that allows you to see the progress of the execution.
+    // Whenever the task awaits something, it is suspended and its worker thread is free to run other tasks.
+    template <typename T>
+    FutureHandle<T> spawn(Task<T>&& task) {
+        auto fut = detail::makeFuture<T>();
+        auto driver = detail::driveTask(std::move(task), fut);
+
+        this->runAsync([h = driver.handle] {
+            h.resume();
+        });
+
+        return FutureHandle<T>(std::move(fut));
     }
 
 private:
@@ -56,8 +172,29 @@ private:
     Runtime();
 
     void runAsync(std::function<void()>&& f);
+    void runLocalUntil(const std::function<bool()>& done);
+    void wakeLocal(bool& done);
 };
 
+// Spawns a future on the given executor, such as a named `Runtime`, and returns a handle to it.
+template <typename F, typename FOut = typename std::invoke_result_t<F>>
+FutureHandle<FOut> spawnOn(Executor& executor, F&& func) {
+    return detail::scheduleFuture<FOut>(executor, new detail::SpawnedFuture<FOut, std::decay_t<F>>(std::forward<F>(func)));
+}
+
+// Runs the coroutine on the given executor, and returns a handle to it.
+template <typename T>
+FutureHandle<T> spawnOn(Executor& executor, Task<T>&& task) {
+    auto fut = detail::makeFuture<T>();
+    auto driver = detail::driveTask(std::move(task), fut);
+
+    executor.execute([h = driver.handle] {
+        h.resume();
+    });
+
+    return FutureHandle<T>(std::move(fut));
+}
+
 
 // Equivalent to `Runtime::get().spawn(func)`
 template <typename F, typename FOut = typename std::invoke_result_t<F>>
@@ -71,6 +208,24 @@ FutureHandle<FOut> spawn(const F& func) {
     return Runtime::get().spawn<F, FOut>(func);
 }
 
+// Equivalent to `Runtime::get().spawn(token, func)`
+template <typename F, typename FOut = typename std::invoke_result_t<F>>
+FutureHandle<FOut> spawn(const CancellationToken& token, F&& func) {
+    return Runtime::get().spawn(token, std::forward<F>(func));
+}
+
+// Equivalent to `Runtime::get().spawnBlocking(func)`
+template <typename F, typename FOut = typename std::invoke_result_t<F>>
+FutureHandle<FOut> spawnBlocking(F&& func) {
+    return Runtime::get().spawnBlocking(std::forward<F>(func));
+}
+
+// Equivalent to `Runtime::get().spawn(task)`
+template <typename T>
+FutureHandle<T> spawn(Task<T>&& task) {
+    return Runtime::get().spawn(std::move(task));
+}
+
 template<typename... Futures>
 std::tuple<> _await_helper(const Futures&...) {
     return std::make_tuple();
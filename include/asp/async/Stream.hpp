@@ -0,0 +1,279 @@
+#pragma once
+
+#include "../config.hpp"
+#include "AsyncChannel.hpp"
+#include "AsyncSemaphore.hpp"
+#include "Future.hpp"
+#include "Runtime.hpp"
+#include "Task.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace asp::async {
+
+// Asynchronous generator, a coroutine that produces a sequence of values with `co_yield` and may `co_await` in between.
+// A `Stream` is pull-based, its body only runs when the consumer asks for the next value, so a slow consumer naturally
+// holds back the producer. Use `buffered(n)` to let the producer run ahead by up to `n` values.
+//
+// ```
+// Stream<Chunk> download(Url url) {
+//     while (...) co_yield co_await fetchChunk(url);
+// }
+//
+// auto stream = download(url);
+// while (auto chunk = co_await stream.next()) { ... }
+// ```
+template <typename T>
+class Stream {
+public:
+    class promise_type {
+    public:
+        Stream get_return_object() {
+            return Stream(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        auto final_suspend() noexcept {
+            return ToConsumer{};
+        }
+
+        // store the value and hand control back to the consumer
+        auto yield_value(T val) {
+            current.emplace(std::move(val));
+            return ToConsumer{};
+        }
+
+        void return_void() {}
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+
+    private:
+        friend class Stream;
+
+        struct ToConsumer {
+            bool await_ready() noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                return h.promise().consumer;
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        std::optional<T> current;
+        std::exception_ptr exception;
+        std::coroutine_handle<> consumer;
+    };
+
+    Stream(const Stream&) = delete;
+    Stream& operator=(const Stream&) = delete;
+
+    Stream(Stream&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    Stream& operator=(Stream&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+
+        return *this;
+    }
+
+    ~Stream() {
+        if (handle) handle.destroy();
+    }
+
+    // Returns an awaitable that resumes the stream until it yields the next value.
+    // Completes with `std::nullopt` once the stream has ended, or rethrows the exception the stream has thrown.
+    auto next() {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() {
+                return handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) {
+                handle.promise().consumer = consumer;
+                return handle;
+            }
+
+            std::optional<T> await_resume() {
+                auto& promise = handle.promise();
+
+                if (promise.exception) {
+                    std::rethrow_exception(std::exchange(promise.exception, nullptr));
+                }
+
+                return std::exchange(promise.current, std::nullopt);
+            }
+        };
+
+        ASP_ALWAYS_ASSERT(handle, "cannot iterate an empty Stream");
+
+        return Awaiter{handle};
+    }
+
+    // Returns a stream of `f(value)` for every value of this stream.
+    template <typename F, typename R = std::invoke_result_t<F, T&&>>
+    Stream<R> map(F f) && {
+        return mapImpl<F, R>(std::move(*this), std::move(f));
+    }
+
+    // Returns a stream of the values of this stream for which `pred(value)` returns `true`.
+    template <typename F>
+    Stream<T> filter(F pred) && {
+        return filterImpl(std::move(*this), std::move(pred));
+    }
+
+    // Runs this stream ahead of the consumer on the runtime of the calling thread, keeping up to `n` values ready.
+    // If the returned stream is dropped before it ends, the producer stops after the value it is currently producing.
+    Stream<T> buffered(size_t n) && {
+        ASP_ALWAYS_ASSERT(n != 0, "cannot buffer a Stream with a capacity of 0");
+        return bufferedImpl(std::move(*this), n);
+    }
+
+    // Calls `f(value)` for every value of this stream, with at most `n` calls running at once on the runtime of the calling thread.
+    // `f` can return either nothing or a `Task<void>`. The returned future completes once every call has finished,
+    // and fails if the stream or any of the calls threw.
+    template <typename F>
+    FutureHandle<void> forEachConcurrent(size_t n, F f) && {
+        ASP_ALWAYS_ASSERT(n != 0, "cannot call forEachConcurrent with a limit of 0");
+        return spawnOn(currentExecutor(), forEachImpl(std::move(*this), n, std::move(f)));
+    }
+
+private:
+    template <typename>
+    friend class Stream;
+
+    std::coroutine_handle<promise_type> handle;
+
+    Stream(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    template <typename F, typename R>
+    static Stream<R> mapImpl(Stream self, F f) {
+        while (auto val = co_await self.next()) {
+            co_yield f(std::move(*val));
+        }
+    }
+
+    template <typename F>
+    static Stream<T> filterImpl(Stream self, F pred) {
+        while (auto val = co_await self.next()) {
+            if (pred(*val)) {
+                co_yield std::move(*val);
+            }
+        }
+    }
+
+    struct BufferState {
+        // `std::nullopt` marks the end of the stream
+        AsyncChannel<std::optional<T>> channel;
+        std::exception_ptr exception;
+
+        BufferState(size_t n) : channel(n) {}
+    };
+
+    // Closes the channel once the buffered stream ends or is dropped, which releases a producer that is waiting for room.
+    struct CloseOnExit {
+        BufferState& state;
+
+        ~CloseOnExit() {
+            state.channel.close();
+        }
+    };
+
+    static Task<void> pump(Stream self, std::shared_ptr<BufferState> state) {
+        try {
+            while (!state->channel.isClosed()) {
+                auto val = co_await self.next();
+                if (!val) break;
+
+                co_await state->channel.send(std::move(val));
+            }
+        } catch (...) {
+            state->exception = std::current_exception();
+        }
+
+        co_await state->channel.send(std::nullopt);
+    }
+
+    static Stream<T> bufferedImpl(Stream self, size_t n) {
+        auto state = std::make_shared<BufferState>(n);
+        CloseOnExit closer{*state};
+
+        spawnOn(currentExecutor(), pump(std::move(self), state));
+
+        while (true) {
+            auto val = std::move(co_await state->channel.recv());
+            if (!val) break;
+
+            co_yield std::move(*val);
+        }
+
+        if (state->exception) {
+            std::rethrow_exception(state->exception);
+        }
+    }
+
+    struct ForEachState {
+        AsyncSemaphore sem;
+        std::mutex mtx;
+        std::exception_ptr exception;
+
+        ForEachState(size_t n) : sem(n) {}
+    };
+
+    // `permit` is only held so that it is released once the call finishes.
+    template <typename F>
+    static Task<void> runOne(std::shared_ptr<ForEachState> state, [[maybe_unused]] AsyncSemaphore::Permit permit, F& f, T val) {
+        try {
+            if constexpr (std::is_void_v<std::invoke_result_t<F&, T&&>>) {
+                f(std::move(val));
+            } else {
+                co_await f(std::move(val));
+            }
+        } catch (...) {
+            std::lock_guard lock(state->mtx);
+            if (!state->exception) state->exception = std::current_exception();
+        }
+    }
+
+    template <typename F>
+    static Task<void> forEachImpl(Stream self, size_t n, F f) {
+        auto state = std::make_shared<ForEachState>(n);
+        std::exception_ptr streamError;
+
+        try {
+            while (auto val = co_await self.next()) {
+                auto permit = co_await state->sem.acquire();
+                spawnOn(currentExecutor(), runOne(state, std::move(permit), f, std::move(*val)));
+            }
+        } catch (...) {
+            streamError = std::current_exception();
+        }
+
+        // once every permit is back, all of the calls have finished
+        std::vector<AsyncSemaphore::Permit> permits;
+        permits.reserve(n);
+
+        for (size_t i = 0; i < n; i++) {
+            permits.push_back(co_await state->sem.acquire());
+        }
+
+        if (streamError) std::rethrow_exception(streamError);
+        if (state->exception) std::rethrow_exception(state->exception);
+    }
+};
+
+}
\ No newline at end of file
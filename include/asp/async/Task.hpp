@@ -0,0 +1,176 @@
+#pragma once
+
+#include "../config.hpp"
+#include "Future.hpp"
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <utility>
+
+namespace asp::async {
+
+namespace detail {
+    template <typename T>
+    class TaskResult {
+    public:
+        void return_value(T val) {
+            value.emplace(std::move(val));
+        }
+
+        T take() {
+            return std::move(*value);
+        }
+
+    private:
+        std::optional<T> value;
+    };
+
+    template <>
+    class TaskResult<void> {
+    public:
+        void return_void() {}
+        void take() {}
+    };
+
+    // Fire-and-forget coroutine that starts suspended and frees itself once it finishes.
+    class DetachedTask {
+    public:
+        struct promise_type {
+            DetachedTask get_return_object() {
+                return DetachedTask(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+
+        std::coroutine_handle<> handle;
+
+    private:
+        DetachedTask(std::coroutine_handle<> handle) : handle(handle) {}
+    };
+}
+
+// Coroutine type for asynchronous functions that do not block a thread while waiting.
+// A `Task` is lazy, its body does not run until it is either awaited with `co_await` from another coroutine,
+// which runs it inline, or passed to `spawn`, which runs it on the `Runtime` and returns a `FutureHandle`.
+//
+// ```
+// Task<int> fetch() {
+//     auto data = co_await $into_async(download());
+//     co_return data.size();
+// }
+// ```
+template <typename T = void>
+class Task {
+public:
+    class promise_type : public detail::TaskResult<T> {
+    public:
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        auto final_suspend() noexcept {
+            struct FinalAwaiter {
+                bool await_ready() noexcept { return false; }
+
+                // transfer control straight to the coroutine that awaited us, if any
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                    auto cont = h.promise().continuation;
+                    return cont ? cont : std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            return FinalAwaiter{};
+        }
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+
+    private:
+        friend class Task;
+
+        std::coroutine_handle<> continuation;
+        std::exception_ptr exception;
+    };
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle) handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+
+        return *this;
+    }
+
+    ~Task() {
+        if (handle) handle.destroy();
+    }
+
+    // Starts the task on the current thread, suspending the awaiting coroutine until the task completes.
+    // Returns the value of the task, or rethrows the exception it has thrown.
+    auto operator co_await() && {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() { return false; }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() {
+                auto& promise = handle.promise();
+
+                if (promise.exception) {
+                    std::rethrow_exception(promise.exception);
+                }
+
+                return promise.take();
+            }
+        };
+
+        ASP_ALWAYS_ASSERT(handle, "cannot await an empty Task");
+
+        return Awaiter{handle};
+    }
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+    Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+};
+
+namespace detail {
+    // Runs the task to completion and stores its result in the given future.
+    template <typename T>
+    DetachedTask driveTask(Task<T> task, FutureRef<T> fut) {
+        try {
+            if constexpr (std::is_void_v<T>) {
+                co_await std::move(task);
+                fut->resolve();
+            } else {
+                fut->resolve(co_await std::move(task));
+            }
+        } catch (const std::exception& e) {
+            fut->reject(e);
+        }
+    }
+}
+
+}
\ No newline at end of file
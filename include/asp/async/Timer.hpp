@@ -0,0 +1,100 @@
+#pragma once
+
+#include "../config.hpp"
+#include "Executor.hpp"
+#include "Future.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+namespace asp::async {
+
+class TimerServiceImpl;
+
+// Error that a future returned by `withTimeout` fails with, if the inner future did not finish in time.
+class TimeoutError : public std::runtime_error {
+public:
+    TimeoutError() : std::runtime_error("future timed out") {}
+};
+
+// Runs callbacks at given points in time, from a single thread that sleeps until the nearest deadline.
+class TimerService {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimerId = uint64_t;
+
+    static TimerService& get();
+
+    TimerService(const TimerService&) = delete;
+    TimerService& operator=(const TimerService&) = delete;
+
+    ~TimerService();
+
+    // Calls `callback` on the timer thread once `deadline` is reached. The callback must not block.
+    TimerId schedule(Clock::time_point deadline, std::function<void()>&& callback);
+
+    // Cancels a timer, returns `false` if it has already fired or been cancelled.
+    bool cancel(TimerId id);
+
+private:
+    std::unique_ptr<TimerServiceImpl> impl;
+
+    TimerService();
+};
+
+// Returns a future that completes at `deadline`, without occupying a thread while waiting.
+// It is completed on `executor`, so a coroutine awaiting it resumes there, by default on the runtime of the calling thread,
+// or on the timer thread if the caller is not running on a runtime.
+FutureHandle<void> sleepUntil(TimerService::Clock::time_point deadline, Executor& executor = currentExecutor());
+
+// Returns a future that completes after `duration`, without occupying a thread while waiting.
+// It is completed on `executor` like `sleepUntil`.
+template <typename Rep, typename Period>
+FutureHandle<void> sleepFor(std::chrono::duration<Rep, Period> duration, Executor& executor = currentExecutor()) {
+    return sleepUntil(TimerService::Clock::now() + std::chrono::duration_cast<TimerService::Clock::duration>(duration), executor);
+}
+
+// Returns a future that completes with the result of `handle`, or fails with a `TimeoutError` if it does not finish within `duration`.
+// On timeout, the inner future is cancelled, so a task that has not started yet never runs, and a pending `AsyncChannel::recv`
+// does not take a message. A task that is already running keeps running, and its result is discarded. A timeout is reported on `executor`.
+template <typename T, typename Rep, typename Period>
+FutureHandle<T> withTimeout(const FutureHandle<T>& handle, std::chrono::duration<Rep, Period> duration, Executor& executor = currentExecutor()) {
+    struct State {
+        detail::FutureRef<T> fut = detail::makeFuture<T>();
+        std::atomic<bool> done = false;
+        TimerService::TimerId timer = 0;
+    };
+
+    auto state = std::make_shared<State>();
+    auto deadline = TimerService::Clock::now() + std::chrono::duration_cast<TimerService::Clock::duration>(duration);
+
+    state->timer = TimerService::get().schedule(deadline, [state, handle, &executor] {
+        if (state->done.exchange(true, std::memory_order::acq_rel)) return;
+
+        executor.execute([state, handle] {
+            handle.cancel();
+            state->fut->propagate(TimeoutError{});
+        });
+    });
+
+    handle.finally([state, handle] {
+        if (state->done.exchange(true, std::memory_order::acq_rel)) return;
+
+        TimerService::get().cancel(state->timer);
+
+        if (handle.hasError()) {
+            state->fut->propagate(handle.getError());
+        } else if constexpr (std::is_void_v<T>) {
+            state->fut->resolve();
+        } else {
+            state->fut->resolve(handle.getResult());
+        }
+    }, InlineExecutor::get());
+
+    return FutureHandle<T>(state->fut);
+}
+
+}
\ No newline at end of file
@@ -1,6 +1,24 @@
 #pragma once
 
 #include <bit>
+#include <cstddef>
+
+namespace asp::detail {
+    // Rounds the amount of shards up to a power of two, so that a shard can be picked by masking an index or a hash.
+    inline constexpr size_t roundShardCount(size_t count) noexcept {
+        return count <= 1 ? 1 : std::bit_ceil(count);
+    }
+
+    // Returns a global instance of `T` that is created on first use and never destroyed.
+    // Meant for globals that other threads may still use while static objects are being destroyed at exit, such as executors
+    // that tasks which are still running post to, or registries that worker threads record into. Destroying those would
+    // turn such late uses into use-after-free, while leaking them costs nothing, as the process is exiting anyway.
+    template <typename T>
+    T& leakedGlobal() {
+        static T* instance = new T();
+        return *instance;
+    }
+}
 
 #if defined(__cpp_lib_bit_cast) && __cpp_lib_bit_cast >= 201806L
 namespace asp::detail {
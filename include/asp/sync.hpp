@@ -1,7 +1,11 @@
 #pragma once
+#include "sync/ArcSwap.hpp"
 #include "sync/Atomic.hpp"
+#include "sync/CachePadded.hpp"
 #include "sync/Channel.hpp"
+#include "sync/ConcurrentMap.hpp"
 #include "sync/Mutex.hpp"
+#include "sync/ShardedCounter.hpp"
 
 namespace asp {
     using namespace ::asp::sync;
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "../config.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace asp::detail {
+    // Hazard slots shared between all `ArcSwap` instances.
+
+    // Loads the pointer stored in `src` and publishes it in a free hazard slot, so that it cannot be freed until the slot is released.
+    std::atomic<void*>* protectHazard(const std::atomic<void*>& src, void*& out);
+    void releaseHazard(std::atomic<void*>* slot);
+
+    // Blocks until `ptr` is no longer published in any hazard slot.
+    void waitForReaders(void* ptr);
+}
+
+namespace asp::sync {
+
+// Holds a `std::shared_ptr<T>` that can be read and replaced from multiple threads without locking on the read side.
+// Meant for data that is read very often and replaced rarely, such as configuration or routing tables.
+// Readers get a snapshot that stays valid for as long as they hold it, the old version is freed once its last reader drops it.
+template <typename T>
+class ArcSwap {
+    using Node = std::shared_ptr<T>;
+
+public:
+    ArcSwap(std::shared_ptr<T> initial = nullptr) : current(new Node(std::move(initial))) {}
+
+    ArcSwap(const ArcSwap&) = delete;
+    ArcSwap& operator=(const ArcSwap&) = delete;
+
+    ~ArcSwap() {
+        delete static_cast<Node*>(current.load(std::memory_order::acquire));
+    }
+
+    // Returns the currently stored value. Never blocks, and only retries if a writer replaced the value at the same time.
+    std::shared_ptr<T> load() const {
+        void* ptr;
+        auto slot = detail::protectHazard(current, ptr);
+
+        std::shared_ptr<T> out = *static_cast<Node*>(ptr);
+
+        detail::releaseHazard(slot);
+        return out;
+    }
+
+    // Replaces the stored value. Waits for readers that are in the middle of `load` to finish copying the old value.
+    void store(std::shared_ptr<T> val) {
+        this->exchange(std::move(val));
+    }
+
+    // Like `store`, but returns the previous value.
+    std::shared_ptr<T> exchange(std::shared_ptr<T> val) {
+        std::lock_guard lock(writeMtx);
+        return this->exchangeLocked(std::move(val));
+    }
+
+    // Replaces the value with the result of `func(old)`, where `func` is a function `const std::shared_ptr<T>& -> std::shared_ptr<T>`.
+    // Writers are serialized, so no concurrent update can be lost in between reading the old value and storing the new one.
+    template <typename F>
+    void update(F&& func) {
+        std::lock_guard lock(writeMtx);
+
+        // we are the only writer, so the node can be read without protecting it
+        const Node& old = *static_cast<Node*>(current.load(std::memory_order::acquire));
+
+        this->exchangeLocked(func(old));
+    }
+
+private:
+    std::atomic<void*> current;
+    std::mutex writeMtx;
+
+    std::shared_ptr<T> exchangeLocked(std::shared_ptr<T> val) {
+        Node* old = static_cast<Node*>(current.exchange(new Node(std::move(val)), std::memory_order::seq_cst));
+
+        detail::waitForReaders(old);
+
+        std::shared_ptr<T> out = std::move(*old);
+        delete old;
+
+        return out;
+    }
+};
+
+}
\ No newline at end of file
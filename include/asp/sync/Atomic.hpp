@@ -35,6 +35,73 @@ public:
         return *this;
     }
 
+    // Replaces the value and returns the previous one.
+    template <typename U = T, std::enable_if_t<!std::is_void_v<U>, U> = 0>
+    T exchange(T val, std::memory_order order = std::memory_order::relaxed) {
+        return value.exchange(val, order);
+    }
+
+    // If the value is equal to `expected`, replaces it with `desired` and returns `true`.
+    // Otherwise, loads the current value into `expected` and returns `false`.
+    template <typename U = T, std::enable_if_t<!std::is_void_v<U>, U> = 0>
+    bool compareExchange(
+        T& expected, T desired,
+        std::memory_order success = std::memory_order::relaxed,
+        std::memory_order failure = std::memory_order::relaxed
+    ) {
+        return value.compare_exchange_strong(expected, desired, success, failure);
+    }
+
+    // Like `compareExchange`, but may spuriously fail even if the value is equal to `expected`. Meant to be used in loops.
+    template <typename U = T, std::enable_if_t<!std::is_void_v<U>, U> = 0>
+    bool compareExchangeWeak(
+        T& expected, T desired,
+        std::memory_order success = std::memory_order::relaxed,
+        std::memory_order failure = std::memory_order::relaxed
+    ) {
+        return value.compare_exchange_weak(expected, desired, success, failure);
+    }
+
+    // The following functions return the value before the modification.
+
+    T fetchAdd(T arg, std::memory_order order = std::memory_order::relaxed) requires (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+        return value.fetch_add(arg, order);
+    }
+
+    T fetchSub(T arg, std::memory_order order = std::memory_order::relaxed) requires (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+        return value.fetch_sub(arg, order);
+    }
+
+    T fetchAnd(T arg, std::memory_order order = std::memory_order::relaxed) requires (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+        return value.fetch_and(arg, order);
+    }
+
+    T fetchOr(T arg, std::memory_order order = std::memory_order::relaxed) requires (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+        return value.fetch_or(arg, order);
+    }
+
+    T fetchXor(T arg, std::memory_order order = std::memory_order::relaxed) requires (std::is_integral_v<T> && !std::is_same_v<T, bool>) {
+        return value.fetch_xor(arg, order);
+    }
+
+    // Blocks the calling thread until the value is no longer equal to `old` and a notify function is called.
+    template <typename U = T, std::enable_if_t<!std::is_void_v<U>, U> = 0>
+    void wait(T old, std::memory_order order = std::memory_order::relaxed) const {
+        value.wait(old, order);
+    }
+
+    // Wakes up at least one thread blocked in `wait`.
+    template <typename U = T, std::enable_if_t<!std::is_void_v<U>, U> = 0>
+    void notifyOne() {
+        value.notify_one();
+    }
+
+    // Wakes up all threads blocked in `wait`.
+    template <typename U = T, std::enable_if_t<!std::is_void_v<U>, U> = 0>
+    void notifyAll() {
+        value.notify_all();
+    }
+
     // enable copying, it is disabled by default in std::atomic
     template <typename U = T, std::enable_if_t<!std::is_void_v<U>, U> = 0>
     Atomic(const Atomic<T, Inner>& other) {
@@ -82,6 +149,7 @@ using AtomicU32 = Atomic<uint32_t>;
 using AtomicI64 = Atomic<int64_t>;
 using AtomicU64 = Atomic<uint64_t>;
 using AtomicF32 = Atomic<float, std::atomic<uint32_t>>;
+using AtomicF64 = Atomic<double, std::atomic<uint64_t>>;
 using AtomicSizeT = Atomic<size_t>;
 
 
@@ -107,6 +175,19 @@ public:
         return value.test_and_set(order);
     }
 
+    // Blocks the calling thread until the flag is no longer equal to `old` and a notify function is called.
+    void wait(bool old, std::memory_order order = std::memory_order::relaxed) const {
+        value.wait(old, order);
+    }
+
+    void notifyOne() {
+        value.notify_one();
+    }
+
+    void notifyAll() {
+        value.notify_all();
+    }
+
     operator bool() const {
         return this->test();
     }
@@ -146,34 +227,89 @@ private:
     std::atomic_flag value;
 };
 
-template <>
-class Atomic<float, std::atomic<uint32_t>> {
+// Atomic floating point numbers, stored as an integer of the same size so that they are lock-free on every platform.
+template <typename F, typename Bits> requires (std::is_floating_point_v<F> && std::is_integral_v<Bits>)
+class Atomic<F, std::atomic<Bits>> {
+    static_assert(sizeof(F) == sizeof(Bits), "floating point atomic must be backed by an integer of the same size");
+
 public:
-    Atomic(float initial = {}) : value(detail::bit_cast<uint32_t>(initial)) {}
+    Atomic(F initial = {}) : value(detail::bit_cast<Bits>(initial)) {}
 
-    float load(std::memory_order order = std::memory_order::relaxed) const {
-        return detail::bit_cast<float>(value.load(order));
+    F load(std::memory_order order = std::memory_order::relaxed) const {
+        return detail::bit_cast<F>(value.load(order));
     }
 
-    void store(float val, std::memory_order order = std::memory_order::relaxed) {
-        value.store(detail::bit_cast<uint32_t>(val), order);
+    void store(F val, std::memory_order order = std::memory_order::relaxed) {
+        value.store(detail::bit_cast<Bits>(val), order);
     }
 
-    operator float() const {
+    operator F() const {
         return this->load();
     }
 
-    Atomic<float, std::atomic<uint32_t>>& operator=(float val) {
+    Atomic<F, std::atomic<Bits>>& operator=(F val) {
         this->store(val);
         return *this;
     }
 
+    F exchange(F val, std::memory_order order = std::memory_order::relaxed) {
+        return detail::bit_cast<F>(value.exchange(detail::bit_cast<Bits>(val), order));
+    }
+
+    // Note that the comparison is bitwise, so for example `0.0` and `-0.0` are not considered equal.
+    bool compareExchange(
+        F& expected, F desired,
+        std::memory_order success = std::memory_order::relaxed,
+        std::memory_order failure = std::memory_order::relaxed
+    ) {
+        Bits exp = detail::bit_cast<Bits>(expected);
+        bool ok = value.compare_exchange_strong(exp, detail::bit_cast<Bits>(desired), success, failure);
+        expected = detail::bit_cast<F>(exp);
+        return ok;
+    }
+
+    bool compareExchangeWeak(
+        F& expected, F desired,
+        std::memory_order success = std::memory_order::relaxed,
+        std::memory_order failure = std::memory_order::relaxed
+    ) {
+        Bits exp = detail::bit_cast<Bits>(expected);
+        bool ok = value.compare_exchange_weak(exp, detail::bit_cast<Bits>(desired), success, failure);
+        expected = detail::bit_cast<F>(exp);
+        return ok;
+    }
+
+    // Returns the value before the addition. Implemented as a CAS loop, as there is no hardware instruction for this.
+    F fetchAdd(F arg, std::memory_order order = std::memory_order::relaxed) {
+        Bits cur = value.load(std::memory_order::relaxed);
+        while (!value.compare_exchange_weak(cur, detail::bit_cast<Bits>(detail::bit_cast<F>(cur) + arg), order, std::memory_order::relaxed)) {}
+
+        return detail::bit_cast<F>(cur);
+    }
+
+    // Returns the value before the subtraction. Implemented as a CAS loop, as there is no hardware instruction for this.
+    F fetchSub(F arg, std::memory_order order = std::memory_order::relaxed) {
+        return this->fetchAdd(-arg, order);
+    }
+
+    void wait(F old, std::memory_order order = std::memory_order::relaxed) const {
+        value.wait(detail::bit_cast<Bits>(old), order);
+    }
+
+    void notifyOne() {
+        value.notify_one();
+    }
+
+    void notifyAll() {
+        value.notify_all();
+    }
+
     // enable copying, it is disabled by default in std::atomic
-    Atomic(Atomic<float, std::atomic<uint32_t>>& other) {
+    Atomic(const Atomic<F, std::atomic<Bits>>& other) {
         this->store(other.load());
     }
 
-    Atomic<float, std::atomic<uint32_t>>& operator=(const Atomic<float, std::atomic<uint32_t>>& other) {
+    Atomic<F, std::atomic<Bits>>& operator=(const Atomic<F, std::atomic<Bits>>& other) {
         if (this != &other) {
             this->store(other.load());
         }
@@ -182,11 +318,11 @@ public:
     }
 
     // moving
-    Atomic(Atomic<float, std::atomic<uint32_t>>&& other) {
+    Atomic(Atomic<F, std::atomic<Bits>>&& other) {
         this->store(other.load());
     }
 
-    Atomic<float, std::atomic<uint32_t>>& operator=(Atomic<float, std::atomic<uint32_t>>&& other) {
+    Atomic<F, std::atomic<Bits>>& operator=(Atomic<F, std::atomic<Bits>>&& other) {
         if (this != &other) {
             this->store(other.load());
         }
@@ -194,7 +330,7 @@ public:
         return *this;
     }
 private:
-    std::atomic<uint32_t> value;
+    std::atomic<Bits> value;
 };
 
 }
\ No newline at end of file
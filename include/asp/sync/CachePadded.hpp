@@ -0,0 +1,65 @@
+#pragma once
+
+#include "../config.hpp"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace asp::detail {
+#if defined(__cpp_lib_hardware_interference_size)
+# if defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC diagnostic push
+#  pragma GCC diagnostic ignored "-Winterference-size"
+# endif
+    inline constexpr size_t CACHE_LINE_SIZE = std::hardware_destructive_interference_size;
+# if defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC diagnostic pop
+# endif
+#else
+    inline constexpr size_t CACHE_LINE_SIZE = 64;
+#endif
+}
+
+namespace asp::sync {
+
+// Wraps a value and aligns it to the size of a cache line, so that it never shares a line with any other data.
+// Use it for data that is frequently written by one thread, to prevent false sharing with its neighbours.
+template <typename T>
+class alignas(detail::CACHE_LINE_SIZE) CachePadded {
+public:
+    CachePadded() : value() {}
+
+    template <typename U> requires (!std::is_same_v<std::remove_cvref_t<U>, CachePadded> && std::is_constructible_v<T, U&&>)
+    CachePadded(U&& val) : value(std::forward<U>(val)) {}
+
+    T& get() {
+        return value;
+    }
+
+    const T& get() const {
+        return value;
+    }
+
+    T& operator*() {
+        return value;
+    }
+
+    const T& operator*() const {
+        return value;
+    }
+
+    T* operator->() {
+        return &value;
+    }
+
+    const T* operator->() const {
+        return &value;
+    }
+
+private:
+    T value;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "../config.hpp"
+#include "../detail/Detail.hpp"
+#include "CachePadded.hpp"
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace asp::sync {
+
+// Hash map that can be accessed from multiple threads at once.
+// Keys are spread over a fixed amount of independently locked shards, lookups only take a shared lock on a single shard,
+// and every shard rehashes on its own, so a growing map never blocks operations on unrelated keys.
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class ConcurrentMap {
+    using Map = std::unordered_map<K, V, Hash, KeyEqual>;
+
+public:
+    // Creates a map with `shardCount` shards, rounded up to a power of two. 0 - pick based on the amount of hardware threads.
+    ConcurrentMap(size_t shardCount = 0) {
+        if (shardCount == 0) {
+            shardCount = std::thread::hardware_concurrency() * 4;
+        }
+
+        size_t count = detail::roundShardCount(shardCount);
+
+        this->shardMask = count - 1;
+        this->shards = std::make_unique<CachePadded<Shard>[]>(count);
+    }
+
+    ConcurrentMap(const ConcurrentMap&) = delete;
+    ConcurrentMap& operator=(const ConcurrentMap&) = delete;
+
+    // Inserts the value if the key is not present yet. Returns whether the insertion took place.
+    bool insert(K key, V value) {
+        auto& shard = this->shardFor(key);
+        std::unique_lock lock(shard.mtx);
+
+        return shard.map.try_emplace(std::move(key), std::move(value)).second;
+    }
+
+    // Inserts the value, or replaces the existing one. Returns `true` if the key was not present before.
+    bool insertOrAssign(K key, V value) {
+        auto& shard = this->shardFor(key);
+        std::unique_lock lock(shard.mtx);
+
+        return shard.map.insert_or_assign(std::move(key), std::move(value)).second;
+    }
+
+    // Removes the key from the map. Returns whether it was present.
+    bool erase(const K& key) {
+        auto& shard = this->shardFor(key);
+        std::unique_lock lock(shard.mtx);
+
+        return shard.map.erase(key) != 0;
+    }
+
+    // Returns a copy of the value associated with the key, or `std::nullopt` if it is not present.
+    std::optional<V> find(const K& key) const {
+        auto& shard = this->shardFor(key);
+        std::shared_lock lock(shard.mtx);
+
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) return std::nullopt;
+
+        return it->second;
+    }
+
+    bool contains(const K& key) const {
+        auto& shard = this->shardFor(key);
+        std::shared_lock lock(shard.mtx);
+
+        return shard.map.contains(key);
+    }
+
+    // Returns a copy of the value associated with the key. If it is not present, `func` is invoked to create it.
+    // Only the shard that owns the key is locked while `func` runs, so it must not access keys that may live in the same shard.
+    template <typename F>
+    V computeIfAbsent(const K& key, F&& func) {
+        auto& shard = this->shardFor(key);
+
+        {
+            std::shared_lock lock(shard.mtx);
+            auto it = shard.map.find(key);
+            if (it != shard.map.end()) return it->second;
+        }
+
+        std::unique_lock lock(shard.mtx);
+
+        // someone might have inserted the key in between the two locks
+        auto it = shard.map.find(key);
+        if (it != shard.map.end()) return it->second;
+
+        return shard.map.emplace(key, func()).first->second;
+    }
+
+    // Invokes `func` with a mutable reference to the value associated with the key, while holding the lock of its shard.
+    // Returns `false` without calling `func` if the key is not present.
+    template <typename F>
+    bool update(const K& key, F&& func) {
+        auto& shard = this->shardFor(key);
+        std::unique_lock lock(shard.mtx);
+
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) return false;
+
+        func(it->second);
+        return true;
+    }
+
+    // Invokes `func` for every key-value pair. Shards are locked one at a time, so the iteration is not an atomic snapshot.
+    template <typename F>
+    void forEach(F&& func) const {
+        for (size_t i = 0; i <= shardMask; i++) {
+            std::shared_lock lock(shards[i]->mtx);
+
+            for (const auto& [key, value] : shards[i]->map) {
+                func(key, value);
+            }
+        }
+    }
+
+    // Returns the amount of elements in the map. The result may already be outdated if the map is being modified concurrently.
+    size_t size() const {
+        size_t total = 0;
+
+        for (size_t i = 0; i <= shardMask; i++) {
+            std::shared_lock lock(shards[i]->mtx);
+            total += shards[i]->map.size();
+        }
+
+        return total;
+    }
+
+    bool empty() const {
+        return this->size() == 0;
+    }
+
+    void clear() {
+        for (size_t i = 0; i <= shardMask; i++) {
+            std::unique_lock lock(shards[i]->mtx);
+            shards[i]->map.clear();
+        }
+    }
+
+private:
+    struct Shard {
+        mutable std::shared_mutex mtx;
+        Map map;
+    };
+
+    std::unique_ptr<CachePadded<Shard>[]> shards;
+    size_t shardMask;
+
+    Shard& shardFor(const K& key) const {
+        // mix the bits, as many std::hash implementations are the identity function for integers
+        size_t h = Hash{}(key) * static_cast<size_t>(0x9E3779B97F4A7C15ull);
+        return *shards[(h >> (sizeof(size_t) * 4)) & shardMask];
+    }
+};
+
+}
\ No newline at end of file
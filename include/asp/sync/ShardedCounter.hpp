@@ -0,0 +1,103 @@
+#pragma once
+
+#include "../config.hpp"
+#include "Atomic.hpp"
+#include "CachePadded.hpp"
+
+#include <cstdint>
+#include <memory>
+
+namespace asp::detail {
+    size_t nextThreadShardIndex();
+
+    // Returns a small number unique to the calling thread, handed out in round-robin order on first use.
+    inline size_t threadShardIndex() {
+        static thread_local size_t index = nextThreadShardIndex();
+        return index;
+    }
+
+    // Returns the default amount of slots for sharded primitives, a power of two based on the amount of hardware threads.
+    size_t defaultShardCount();
+}
+
+namespace asp::sync {
+
+// Counter meant for statistics that are incremented very often from many threads at once.
+// Every thread increments its own cache-line sized slot, and reading the value sums up all of the slots.
+class ShardedCounter {
+public:
+    // Creates a counter with `shards` slots, rounded up to a power of two. 0 - pick based on the amount of hardware threads.
+    ShardedCounter(size_t shards = 0);
+
+    ShardedCounter(const ShardedCounter&) = delete;
+    ShardedCounter& operator=(const ShardedCounter&) = delete;
+
+    void add(uint64_t n = 1) {
+        slots[detail::threadShardIndex() & mask]->fetchAdd(n);
+    }
+
+    // Returns the sum of all slots. Increments that happen concurrently may or may not be included.
+    uint64_t load() const;
+
+    // Sets the counter back to zero. Increments that happen concurrently may be lost.
+    void reset();
+
+private:
+    std::unique_ptr<CachePadded<AtomicU64>[]> slots;
+    size_t mask;
+};
+
+// Like `ShardedCounter`, but records individual samples, such as latencies, and keeps track of their count, sum, minimum and maximum.
+class ShardedSummary {
+public:
+    struct Snapshot {
+        uint64_t count;
+        int64_t sum;
+        // `min` and `max` are only meaningful if `count` is not zero.
+        int64_t min;
+        int64_t max;
+
+        double mean() const {
+            return count == 0 ? 0.0 : static_cast<double>(sum) / static_cast<double>(count);
+        }
+    };
+
+    // Creates a summary with `shards` slots, rounded up to a power of two. 0 - pick based on the amount of hardware threads.
+    ShardedSummary(size_t shards = 0);
+
+    ShardedSummary(const ShardedSummary&) = delete;
+    ShardedSummary& operator=(const ShardedSummary&) = delete;
+
+    void record(int64_t sample) {
+        auto& slot = *slots[detail::threadShardIndex() & mask];
+
+        slot.count.fetchAdd(1);
+        slot.sum.fetchAdd(sample);
+
+        // CAS loops are only entered when the sample actually changes the extremes, which quickly becomes rare
+        int64_t cur = slot.min.load();
+        while (sample < cur && !slot.min.compareExchangeWeak(cur, sample)) {}
+
+        cur = slot.max.load();
+        while (sample > cur && !slot.max.compareExchangeWeak(cur, sample)) {}
+    }
+
+    // Combines all slots into a single snapshot. Samples that are recorded concurrently may be partially included.
+    Snapshot load() const;
+
+    // Discards all recorded samples. Samples that are recorded concurrently may be lost.
+    void reset();
+
+private:
+    struct Slot {
+        AtomicU64 count = 0;
+        AtomicI64 sum = 0;
+        AtomicI64 min = INT64_MAX;
+        AtomicI64 max = INT64_MIN;
+    };
+
+    std::unique_ptr<CachePadded<Slot>[]> slots;
+    size_t mask;
+};
+
+}
\ No newline at end of file
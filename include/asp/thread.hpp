@@ -1,6 +1,8 @@
 #pragma once
+#include "thread/ElasticThreadPool.hpp"
 #include "thread/Thread.hpp"
 #include "thread/ThreadPool.hpp"
+#include "thread/Tracer.hpp"
 
 namespace asp {
     using namespace ::asp::thread;
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "../config.hpp"
+#include "Thread.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+
+namespace asp::thread {
+
+// Thread pool meant for blocking work, such as file I/O. Unlike `ThreadPool`, it starts with no threads,
+// and spawns a new one whenever a task is pushed while all existing threads are busy, up to `maxThreads`.
+// Threads that have been idle for longer than `idleTimeout` exit.
+class ElasticThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    ElasticThreadPool(size_t maxThreads, std::chrono::milliseconds idleTimeout = std::chrono::seconds(10));
+
+    // Waits for all queued tasks to finish and for all threads to exit.
+    ~ElasticThreadPool();
+
+    ElasticThreadPool(const ElasticThreadPool&) = delete;
+    ElasticThreadPool& operator=(const ElasticThreadPool&) = delete;
+
+    void pushTask(const Task& task);
+    void pushTask(Task&& task);
+
+    // Returns the amount of currently alive threads.
+    size_t threadCount();
+
+private:
+    size_t maxThreads;
+    std::chrono::milliseconds idleTimeout;
+
+    std::mutex mtx;
+    std::condition_variable taskCv;
+    std::condition_variable exitCv;
+    std::deque<Task> queue;
+    std::list<Thread<>> workers;
+    // threads that have exited their loop, but have not been joined yet
+    std::list<Thread<>> exited;
+    size_t idle = 0;
+    bool stopping = false;
+
+    void push(Task&& task);
+    void runNext(Thread<>& self);
+};
+
+}
\ No newline at end of file
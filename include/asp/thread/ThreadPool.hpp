@@ -1,11 +1,34 @@
 #pragma once
 
 #include "Thread.hpp"
+#include "Tracer.hpp"
 #include "../sync/Channel.hpp"
 #include "../sync/Atomic.hpp"
+#include "../sync/CachePadded.hpp"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
 
 namespace asp::thread {
 
+// Details about a task that has been running for longer than the watchdog budget.
+struct StallInfo {
+    size_t worker;
+    // label of the task, see `TaskLabel`, or `nullptr`
+    const char* label;
+    std::chrono::nanoseconds elapsed;
+};
+
+struct WatchdogSettings {
+    // How long a single task may run before it is reported.
+    std::chrono::milliseconds budget = std::chrono::seconds(1);
+    // How often the workers are checked.
+    std::chrono::milliseconds interval = std::chrono::milliseconds(100);
+    // Called from the watchdog thread once for every stalled task. If not set, stalls are logged as warnings.
+    std::function<void(const StallInfo&)> onStall;
+};
+
 class ThreadPool {
 public:
     using Task = std::function<void()>;
@@ -25,18 +48,73 @@ public:
     // Returns `true` if the thread pool is currently doing any work, `false` if all threads are sleeping.
     bool isDoingWork();
 
+    // Takes one task from the queue and runs it on the calling thread. Returns `false` if the queue was empty.
+    bool runPendingTask();
+
+    // Returns the thread pool that the calling thread is a worker of, or `nullptr` if it is not a worker thread.
+    static ThreadPool* current();
+
     // Set the function that will be called when a thread throws an exception.
     void setExceptionFunction(const std::function<void(const std::exception&)>& f);
 
+    // Starts a thread that periodically checks how long each worker has been running its current task,
+    // and reports tasks that exceed the budget. Replaces the previous watchdog, if any. Only tasks pushed while a watchdog
+    // is enabled are watched.
+    // Both functions may be called from any thread, but not from the `onStall` callback.
+    void enableWatchdog(WatchdogSettings settings);
+    void disableWatchdog();
+
+    // Returns the amount of tasks that the watchdog has reported as stalled.
+    uint64_t stallCount() const;
+
 private:
+    struct Watchdog;
+
+    // What each worker is currently running, sampled by the watchdog.
+    struct TaskSlot {
+        // steady clock time in nanoseconds, 0 when idle
+        std::atomic<uint64_t> start = 0;
+        std::atomic<const char*> label = nullptr;
+    };
+
+    // Metadata used by the tracer and the watchdog, allocated separately so that uninstrumented tasks stay small.
+    struct TaskMeta {
+        const char* label;
+        // 0 if tracing was disabled when the task was pushed
+        uint64_t id;
+        uint64_t spawnTime;
+        // set when the task is popped from the queue, if it is traced
+        uint64_t dequeueTime;
+        uint32_t spawnThread;
+    };
+
+    struct QueuedTask {
+        Task task;
+        // only set if the tracer or the watchdog was enabled when the task was pushed
+        std::unique_ptr<TaskMeta> meta;
+    };
+
     struct Worker {
         Thread<> thread;
-        sync::AtomicBool doingWork = false;
+        // padded, as it is written by the worker on every task
+        sync::CachePadded<sync::AtomicBool> doingWork = false;
     };
 
     std::vector<Worker> workers;
-    sync::Channel<Task> taskQueue;
+    sync::Channel<QueuedTask> taskQueue;
     std::function<void(const std::exception&)> onException;
+
+    std::unique_ptr<sync::CachePadded<TaskSlot>[]> slots;
+    sync::AtomicBool watchdogActive = false;
+    // guards `watchdog`, held while it is being started or stopped
+    std::mutex watchdogMtx;
+    std::unique_ptr<Watchdog> watchdog;
+    sync::AtomicU64 stalls = 0;
+
+    void stopWatchdog();
+    QueuedTask makeQueued(Task&& task);
+    void runInstrumented(QueuedTask& task, TaskSlot* slot);
+    static void runTraced(QueuedTask& task);
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../config.hpp"
+#include "../sync/Atomic.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace asp::thread {
+
+// Label attached to tasks pushed to a `ThreadPool` from the calling thread while this object is alive,
+// shown by the `Tracer` and by the watchdog. The string must outlive every task it is attached to, usually it is a literal.
+//
+// ```
+// TaskLabel label("load assets");
+// spawn(...);
+// ```
+class TaskLabel {
+public:
+    TaskLabel(const char* label) : prev(std::exchange(currentLabel, label)) {}
+
+    ~TaskLabel() {
+        currentLabel = prev;
+    }
+
+    TaskLabel(const TaskLabel&) = delete;
+    TaskLabel& operator=(const TaskLabel&) = delete;
+
+    // Returns the label of the innermost `TaskLabel` on the calling thread, or `nullptr`.
+    static const char* current() {
+        return currentLabel;
+    }
+
+private:
+    const char* prev;
+    static inline thread_local const char* currentLabel = nullptr;
+};
+
+// Records the timeline of thread pool tasks, to be exported as Chrome Trace Event JSON and viewed in Perfetto or chrome://tracing.
+// Disabled by default, when disabled the cost for every task is a single check of a global flag.
+// Records are appended to per-thread buffers without any locking.
+class Tracer {
+public:
+    struct TaskRecord {
+        uint64_t id;
+        const char* label;
+        uint32_t spawnThread;
+        uint32_t worker;
+        // nanoseconds since the tracer epoch
+        uint64_t spawnTime;
+        uint64_t dequeueTime;
+        uint64_t startTime;
+        uint64_t endTime;
+    };
+
+    static void enable();
+    static void disable();
+
+    static bool enabled() {
+        return enabledFlag.load(std::memory_order::relaxed);
+    }
+
+    // Returns the current time in nanoseconds since the tracer epoch.
+    static uint64_t now();
+
+    // Returns a small id of the calling thread, used as the thread id in the trace.
+    static uint32_t threadId();
+
+    // Names the calling thread in the trace.
+    static void setThreadName(std::string name);
+
+    static uint64_t nextTaskId();
+
+    static void record(const TaskRecord& record);
+
+    // Writes all records so far as Chrome Trace Event JSON.
+    static void dump(std::ostream& out);
+
+    // Like `dump`, but writes to a file. Returns `false` if the file could not be opened.
+    static bool dumpToFile(const std::string& path);
+
+    // Drops all records. Must not be called while tasks are being recorded.
+    static void clear();
+
+private:
+    static inline sync::AtomicBool enabledFlag = false;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include <asp/async/AsyncSemaphore.hpp>
+#include <asp/async/Executor.hpp>
+
+namespace asp::async {
+
+AsyncSemaphore::AsyncSemaphore(size_t permits) : permits(permits) {}
+
+bool AsyncSemaphore::tryTake() {
+    std::lock_guard lock(mtx);
+
+    // don't let new acquirers barge ahead of queued ones
+    if (permits == 0 || head) return false;
+
+    permits--;
+    return true;
+}
+
+bool AsyncSemaphore::enqueue(Acquire* waiter) {
+    std::lock_guard lock(mtx);
+
+    if (permits > 0 && !head) {
+        permits--;
+        return false;
+    }
+
+    if (tail) {
+        tail->next = waiter;
+    } else {
+        head = waiter;
+    }
+
+    tail = waiter;
+
+    return true;
+}
+
+void AsyncSemaphore::release() {
+    Acquire* waiter;
+
+    {
+        std::lock_guard lock(mtx);
+
+        if (!head) {
+            permits++;
+            return;
+        }
+
+        // the permit goes straight to the oldest waiter
+        waiter = head;
+        head = waiter->next;
+        if (!head) tail = nullptr;
+    }
+
+    waiter->executor->execute([h = waiter->handle] {
+        h.resume();
+    });
+}
+
+size_t AsyncSemaphore::available() const {
+    std::lock_guard lock(mtx);
+    return permits;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include <asp/async/Cancellation.hpp>
+#include <asp/sync/Atomic.hpp>
+
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace asp::async {
+
+namespace detail {
+    class CancellationState {
+    public:
+        sync::AtomicBool cancelled = false;
+        std::mutex mtx;
+        std::vector<std::pair<CancellationToken::CallbackId, std::function<void()>>> callbacks;
+        CancellationToken::CallbackId nextId = 1;
+    };
+}
+
+/* CancellationToken */
+
+bool CancellationToken::isCancelled() const {
+    return state && state->cancelled.load(std::memory_order::acquire);
+}
+
+void CancellationToken::throwIfCancelled() const {
+    if (this->isCancelled()) {
+        throw CancelledError();
+    }
+}
+
+CancellationToken::CallbackId CancellationToken::onCancel(std::function<void()>&& f) const {
+    if (!state) return 0;
+
+    {
+        std::lock_guard lock(state->mtx);
+
+        if (!state->cancelled.load(std::memory_order::relaxed)) {
+            auto id = state->nextId++;
+            state->callbacks.emplace_back(id, std::move(f));
+            return id;
+        }
+    }
+
+    f();
+    return 0;
+}
+
+void CancellationToken::removeCallback(CallbackId id) const {
+    if (!state || id == 0) return;
+
+    std::function<void()> removed;
+    std::lock_guard lock(state->mtx);
+
+    for (auto it = state->callbacks.begin(); it != state->callbacks.end(); it++) {
+        if (it->first == id) {
+            removed = std::move(it->second);
+            state->callbacks.erase(it);
+            break;
+        }
+    }
+}
+
+/* CancellationSource */
+
+CancellationSource::CancellationSource() : state(std::make_shared<detail::CancellationState>()) {}
+
+CancellationToken CancellationSource::token() const {
+    return CancellationToken(state);
+}
+
+void CancellationSource::cancel() {
+    decltype(state->callbacks) callbacks;
+
+    {
+        std::lock_guard lock(state->mtx);
+
+        if (state->cancelled.load(std::memory_order::relaxed)) return;
+
+        state->cancelled.store(true, std::memory_order::release);
+        callbacks = std::move(state->callbacks);
+    }
+
+    for (auto& [id, cb] : callbacks) {
+        cb();
+    }
+}
+
+bool CancellationSource::isCancelled() const {
+    return state->cancelled.load(std::memory_order::acquire);
+}
+
+}
\ No newline at end of file
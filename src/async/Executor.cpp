@@ -0,0 +1,15 @@
+#include <asp/async/Executor.hpp>
+#include <asp/async/Runtime.hpp>
+#include <asp/detail/Detail.hpp>
+
+namespace asp::async {
+
+InlineExecutor& InlineExecutor::get() {
+    return asp::detail::leakedGlobal<InlineExecutor>();
+}
+
+Executor& defaultExecutor() {
+    return Runtime::get();
+}
+
+}
\ No newline at end of file
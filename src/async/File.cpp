@@ -0,0 +1,436 @@
+#include <asp/async/File.hpp>
+#include <asp/async/Runtime.hpp>
+#include <asp/Log.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <system_error>
+
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# define NOMINMAX
+# include <windows.h>
+# include <io.h>
+#else
+# include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(ASP_ENABLE_IO_URING)
+# define ASP_USE_IO_URING
+#endif
+
+#ifdef ASP_USE_IO_URING
+# include <cstring>
+# include <functional>
+# include <mutex>
+# include <thread>
+# include <linux/io_uring.h>
+# include <sys/mman.h>
+# include <sys/syscall.h>
+#endif
+
+namespace asp::async {
+
+// Blocking implementations, ran on the blocking thread pool when io_uring is not used.
+namespace {
+#ifdef _WIN32
+    [[noreturn]] void throwLastError(DWORD err, const char* what) {
+        throw std::system_error(static_cast<int>(err), std::system_category(), what);
+    }
+
+    HANDLE handleOf(int fd) {
+        return reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+    }
+
+    // Positional I/O on Windows is done by passing the offset in an `OVERLAPPED`, which also works for handles
+    // that were not opened for overlapped I/O, in which case the call simply completes synchronously.
+    template <typename F>
+    size_t overlappedIo(int fd, uint64_t offset, const char* what, F&& op) {
+        HANDLE handle = handleOf(fd);
+
+        OVERLAPPED ov{};
+        ov.Offset = static_cast<DWORD>(offset);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        DWORD n = 0;
+
+        if (!op(handle, &n, &ov)) {
+            DWORD err = GetLastError();
+
+            if (err == ERROR_IO_PENDING) {
+                if (!GetOverlappedResult(handle, &ov, &n, TRUE)) {
+                    err = GetLastError();
+                    if (err != ERROR_HANDLE_EOF) throwLastError(err, what);
+                }
+            } else if (err != ERROR_HANDLE_EOF) {
+                throwLastError(err, what);
+            }
+        }
+
+        return n;
+    }
+
+    // Windows lengths are 32-bit, longer requests are completed partially
+    DWORD clampDword(size_t len) {
+        return static_cast<DWORD>(std::min<size_t>(len, MAXDWORD));
+    }
+
+    size_t blockingRead(int fd, void* buf, size_t len, uint64_t offset) {
+        return overlappedIo(fd, offset, "ReadFile", [&](HANDLE h, DWORD* n, OVERLAPPED* ov) {
+            return ReadFile(h, buf, clampDword(len), n, ov);
+        });
+    }
+
+    size_t blockingWrite(int fd, const void* buf, size_t len, uint64_t offset) {
+        return overlappedIo(fd, offset, "WriteFile", [&](HANDLE h, DWORD* n, OVERLAPPED* ov) {
+            return WriteFile(h, buf, clampDword(len), n, ov);
+        });
+    }
+
+    void blockingSync(int fd) {
+        if (!FlushFileBuffers(handleOf(fd))) {
+            throwLastError(GetLastError(), "FlushFileBuffers");
+        }
+    }
+#else
+    template <typename F>
+    size_t retryInterrupted(const char* what, F&& op) {
+        ssize_t n;
+
+        do {
+            n = op();
+        } while (n < 0 && errno == EINTR);
+
+        if (n < 0) {
+            throw std::system_error(errno, std::generic_category(), what);
+        }
+
+        return static_cast<size_t>(n);
+    }
+
+    size_t blockingRead(int fd, void* buf, size_t len, uint64_t offset) {
+        return retryInterrupted("pread", [&] { return ::pread(fd, buf, len, static_cast<off_t>(offset)); });
+    }
+
+    size_t blockingWrite(int fd, const void* buf, size_t len, uint64_t offset) {
+        return retryInterrupted("pwrite", [&] { return ::pwrite(fd, buf, len, static_cast<off_t>(offset)); });
+    }
+
+    void blockingSync(int fd) {
+        retryInterrupted("fsync", [&] { return ::fsync(fd); });
+    }
+#endif
+}
+
+#ifdef ASP_USE_IO_URING
+
+namespace {
+    // Minimal io_uring wrapper using the raw syscalls, so that liburing is not needed.
+    // Submissions are made by the callers, completions are reaped by a dedicated thread.
+    class IoUring {
+    public:
+        using Completion = std::function<void(int)>;
+
+        static IoUring* get() {
+            static IoUring ring;
+            return ring.ok ? &ring : nullptr;
+        }
+
+        IoUring() {
+            io_uring_params params{};
+            ringFd = static_cast<int>(syscall(__NR_io_uring_setup, ENTRIES, &params));
+
+            if (ringFd < 0) {
+                asp::trace(std::string("io_uring is unavailable, falling back to the blocking pool: ") + std::strerror(errno));
+                return;
+            }
+
+            if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !this->map(params)) {
+                asp::trace("io_uring is missing required features, falling back to the blocking pool");
+                ::close(ringFd);
+                return;
+            }
+
+            ok = true;
+            thread = std::thread([this] { this->reap(); });
+        }
+
+        ~IoUring() {
+            if (!ok) return;
+
+            // a nop with no user data tells the reaper thread to exit
+            this->submit([](io_uring_sqe* sqe) {
+                sqe->opcode = IORING_OP_NOP;
+            }, nullptr);
+
+            thread.join();
+
+            munmap(sqes, sqesSize);
+            munmap(ringPtr, ringSize);
+            ::close(ringFd);
+        }
+
+        // Fills a submission entry with `prepare` and submits it. `done` is called with the result once it completes.
+        template <typename F>
+        void submit(F&& prepare, Completion* done) {
+            std::unique_lock lock(mtx);
+
+            // wait for a free entry, the kernel consumes them on every submit
+            while (*sqTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+                if (!flushing) {
+                    this->flushLocked(lock);
+                } else {
+                    lock.unlock();
+                    std::this_thread::yield();
+                    lock.lock();
+                }
+            }
+
+            unsigned tail = *sqTail;
+            unsigned index = tail & sqMask;
+
+            auto sqe = &sqes[index];
+            std::memset(sqe, 0, sizeof(*sqe));
+            prepare(sqe);
+            sqe->user_data = reinterpret_cast<uint64_t>(done);
+
+            sqArray[index] = index;
+            __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+            unsubmitted++;
+
+            // whoever is already inside of io_uring_enter will pick this entry up on its next round
+            if (!flushing) {
+                this->flushLocked(lock);
+            }
+        }
+
+    private:
+        static constexpr unsigned ENTRIES = 256;
+
+        bool ok = false;
+        int ringFd = -1;
+
+        void* ringPtr = nullptr;
+        size_t ringSize = 0;
+        io_uring_sqe* sqes = nullptr;
+        size_t sqesSize = 0;
+
+        unsigned* sqHead;
+        unsigned* sqTail;
+        unsigned* sqArray;
+        unsigned sqMask;
+        unsigned sqEntries;
+
+        unsigned* cqHead;
+        unsigned* cqTail;
+        unsigned cqMask;
+        io_uring_cqe* cqes;
+
+        std::mutex mtx;
+        unsigned unsubmitted = 0;
+        bool flushing = false;
+        std::thread thread;
+
+        bool map(const io_uring_params& p) {
+            size_t sqSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+            size_t cqSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+            ringSize = std::max(sqSize, cqSize);
+
+            ringPtr = mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+            if (ringPtr == MAP_FAILED) return false;
+
+            sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+            void* sqePtr = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+            if (sqePtr == MAP_FAILED) {
+                munmap(ringPtr, ringSize);
+                return false;
+            }
+
+            auto base = static_cast<char*>(ringPtr);
+
+            sqHead = reinterpret_cast<unsigned*>(base + p.sq_off.head);
+            sqTail = reinterpret_cast<unsigned*>(base + p.sq_off.tail);
+            sqArray = reinterpret_cast<unsigned*>(base + p.sq_off.array);
+            sqMask = *reinterpret_cast<unsigned*>(base + p.sq_off.ring_mask);
+            sqEntries = *reinterpret_cast<unsigned*>(base + p.sq_off.ring_entries);
+            sqes = static_cast<io_uring_sqe*>(sqePtr);
+
+            cqHead = reinterpret_cast<unsigned*>(base + p.cq_off.head);
+            cqTail = reinterpret_cast<unsigned*>(base + p.cq_off.tail);
+            cqMask = *reinterpret_cast<unsigned*>(base + p.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe*>(base + p.cq_off.cqes);
+
+            return true;
+        }
+
+        // Submits everything that has been queued, including entries added by other threads while the syscall runs.
+        void flushLocked(std::unique_lock<std::mutex>& lock) {
+            flushing = true;
+
+            while (unsubmitted != 0) {
+                unsigned count = unsubmitted;
+                unsubmitted = 0;
+
+                lock.unlock();
+
+                int res;
+                do {
+                    res = static_cast<int>(syscall(__NR_io_uring_enter, ringFd, count, 0, 0, nullptr, 0));
+                } while (res < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY));
+
+                if (res < 0) {
+                    asp::log(LogLevel::Error, std::string("io_uring_enter failed: ") + std::strerror(errno));
+                }
+
+                lock.lock();
+            }
+
+            flushing = false;
+        }
+
+        void reap() {
+            while (true) {
+                int res = static_cast<int>(syscall(__NR_io_uring_enter, ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0));
+
+                if (res < 0 && errno != EINTR) {
+                    asp::log(LogLevel::Error, std::string("io_uring_enter failed: ") + std::strerror(errno));
+                    return;
+                }
+
+                unsigned head = *cqHead;
+                unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+                bool stop = false;
+
+                for (; head != tail; head++) {
+                    auto& cqe = cqes[head & cqMask];
+                    auto done = reinterpret_cast<Completion*>(cqe.user_data);
+
+                    if (!done) {
+                        stop = true;
+                        continue;
+                    }
+
+                    (*done)(cqe.res);
+                    delete done;
+                }
+
+                __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+                if (stop) return;
+            }
+        }
+    };
+
+    // Hands the result over to the executor of the submitting thread (see `currentExecutor()`), so that no user code runs
+    // on the reaper thread. If the kernel does not support the operation, it is ran with `fallback` on the blocking pool instead.
+    template <typename T, typename F>
+    IoUring::Completion* completeWith(Promise<T> promise, const char* what, F&& fallback) {
+        auto& executor = currentExecutor();
+
+        return new IoUring::Completion([promise, what, fallback = std::forward<F>(fallback), &executor](int res) {
+            if (res == -EINVAL || res == -EOPNOTSUPP) {
+                Runtime::get().blockingExecutor().execute([promise, fallback] {
+                    try {
+                        if constexpr (std::is_void_v<T>) {
+                            fallback();
+                            promise.resolve();
+                        } else {
+                            promise.resolve(fallback());
+                        }
+                    } catch (const std::exception& e) {
+                        promise.reject(e);
+                    }
+                });
+
+                return;
+            }
+
+            executor.execute([promise, what, res] {
+                if (res < 0) {
+                    promise.reject(std::system_error(-res, std::generic_category(), what));
+                } else if constexpr (std::is_void_v<T>) {
+                    promise.resolve();
+                } else {
+                    promise.resolve(static_cast<T>(res));
+                }
+            });
+        });
+    }
+
+    // io_uring lengths are 32-bit, longer requests are completed partially like a regular `pread` could be
+    uint32_t clampLength(size_t len) {
+        return static_cast<uint32_t>(std::min<size_t>(len, UINT32_MAX));
+    }
+}
+
+#endif
+
+FutureHandle<size_t> readAt(int fd, void* buf, size_t len, uint64_t offset) {
+#ifdef ASP_USE_IO_URING
+    if (auto ring = IoUring::get()) {
+        Promise<size_t> promise;
+
+        ring->submit([&](io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<uint64_t>(buf);
+            sqe->len = clampLength(len);
+            sqe->off = offset;
+        }, completeWith(promise, "read", [=] { return blockingRead(fd, buf, len, offset); }));
+
+        return promise.getFuture();
+    }
+#endif
+
+    return spawnBlocking([=] { return blockingRead(fd, buf, len, offset); });
+}
+
+FutureHandle<size_t> writeAt(int fd, const void* buf, size_t len, uint64_t offset) {
+#ifdef ASP_USE_IO_URING
+    if (auto ring = IoUring::get()) {
+        Promise<size_t> promise;
+
+        ring->submit([&](io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_WRITE;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<uint64_t>(buf);
+            sqe->len = clampLength(len);
+            sqe->off = offset;
+        }, completeWith(promise, "write", [=] { return blockingWrite(fd, buf, len, offset); }));
+
+        return promise.getFuture();
+    }
+#endif
+
+    return spawnBlocking([=] { return blockingWrite(fd, buf, len, offset); });
+}
+
+FutureHandle<void> fsyncFile(int fd) {
+#ifdef ASP_USE_IO_URING
+    if (auto ring = IoUring::get()) {
+        Promise<void> promise;
+
+        ring->submit([&](io_uring_sqe* sqe) {
+            sqe->opcode = IORING_OP_FSYNC;
+            sqe->fd = fd;
+        }, completeWith(promise, "fsync", [fd] { blockingSync(fd); }));
+
+        return promise.getFuture();
+    }
+#endif
+
+    return spawnBlocking([fd] {
+        blockingSync(fd);
+    });
+}
+
+bool usingIoUring() {
+#ifdef ASP_USE_IO_URING
+    return IoUring::get() != nullptr;
+#else
+    return false;
+#endif
+}
+
+}
\ No newline at end of file
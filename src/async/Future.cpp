@@ -1,12 +1,37 @@
 #include <asp/async/Future.hpp>
+#include <asp/async/Runtime.hpp>
 #include <asp/Log.hpp>
+#include <asp/thread/ThreadPool.hpp>
 
 namespace asp::async {
 
 namespace detail {
+    static constexpr size_t MAX_HELP_DEPTH = 128;
+    static thread_local size_t helpDepth = 0;
+
     void futureFail(const std::exception& e) {
         asp::log(asp::LogLevel::Error, std::string("Future threw: ") + e.what());
     }
+
+    bool isWorkerThread() {
+        return thread::ThreadPool::current() != nullptr || ownsCurrentThreadRuntime();
+    }
+
+    bool runPendingTask() {
+        if (auto pool = thread::ThreadPool::current()) {
+            return pool->runPendingTask();
+        }
+
+        return runCurrentThreadTask();
+    }
+
+    HelpScope::HelpScope() : entered(helpDepth < MAX_HELP_DEPTH) {
+        if (entered) helpDepth++;
+    }
+
+    HelpScope::~HelpScope() {
+        if (entered) helpDepth--;
+    }
 }
 
 }
\ No newline at end of file
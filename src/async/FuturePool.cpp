@@ -0,0 +1,206 @@
+#include <asp/async/Future.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace asp::async::detail {
+
+namespace {
+    constexpr size_t CLASS_STEP = 64;
+    constexpr size_t CLASS_COUNT = 16;
+    constexpr size_t MAX_CACHED_PER_CLASS = 256;
+    constexpr uint32_t UNPOOLED = UINT32_MAX;
+
+    struct ThreadCache;
+
+    // Placed in front of every block, keeps the user pointer aligned to `max_align_t`.
+    struct alignas(alignof(std::max_align_t)) BlockHeader {
+        ThreadCache* owner;
+        uint32_t sizeClass;
+    };
+
+    struct FreeNode {
+        FreeNode* next;
+    };
+
+    struct ThreadCache {
+        FreeNode* local[CLASS_COUNT] = {};
+        size_t localCount[CLASS_COUNT] = {};
+
+        // blocks freed by other threads, taken back by the owner once its local list runs dry
+        std::atomic<FreeNode*> remote = nullptr;
+    };
+
+    BlockHeader* headerOf(void* ptr) {
+        return reinterpret_cast<BlockHeader*>(static_cast<char*>(ptr) - sizeof(BlockHeader));
+    }
+
+    void* userOf(BlockHeader* header) {
+        return reinterpret_cast<char*>(header) + sizeof(BlockHeader);
+    }
+
+    // Takes back the blocks freed by other threads. Blocks that do not fit in the local lists are freed.
+    void drainRemote(ThreadCache* cache) {
+        auto node = cache->remote.exchange(nullptr, std::memory_order::acquire);
+
+        while (node) {
+            auto next = node->next;
+            auto cls = headerOf(node)->sizeClass;
+
+            if (cache->localCount[cls] >= MAX_CACHED_PER_CLASS) {
+                ::operator delete(headerOf(node));
+            } else {
+                node->next = cache->local[cls];
+                cache->local[cls] = node;
+                cache->localCount[cls]++;
+            }
+
+            node = next;
+        }
+    }
+
+    // Frees every block held by the cache, except for ones that are handed back to it afterwards.
+    void releaseBlocks(ThreadCache* cache) {
+        drainRemote(cache);
+
+        for (size_t cls = 0; cls < CLASS_COUNT; cls++) {
+            auto node = cache->local[cls];
+
+            while (node) {
+                auto next = node->next;
+                ::operator delete(headerOf(node));
+                node = next;
+            }
+
+            cache->local[cls] = nullptr;
+            cache->localCount[cls] = 0;
+        }
+    }
+
+    // Caches of exited threads. Other threads may still be returning blocks to them, so they are never freed,
+    // instead they get adopted by the next thread that needs a cache. Leaked, so that the caches stay reachable at exit.
+    std::mutex orphanMtx;
+    std::vector<ThreadCache*>& orphans = *new std::vector<ThreadCache*>();
+
+    // Frees the blocks held by orphaned caches when the program exits, after the main thread has given up its cache.
+    struct OrphanReaper {
+        ~OrphanReaper() {
+            std::lock_guard lock(orphanMtx);
+
+            for (auto cache : orphans) {
+                releaseBlocks(cache);
+            }
+        }
+    } orphanReaper;
+
+    ThreadCache* acquireCache() {
+        std::lock_guard lock(orphanMtx);
+
+        if (!orphans.empty()) {
+            auto cache = orphans.back();
+            orphans.pop_back();
+
+            // blocks returned while the cache was orphaned
+            drainRemote(cache);
+
+            return cache;
+        }
+
+        return new ThreadCache();
+    }
+
+    thread_local ThreadCache* currentCache = nullptr;
+    thread_local bool cacheDestroyed = false;
+
+    struct CacheOwner {
+        ~CacheOwner() {
+            cacheDestroyed = true;
+
+            if (currentCache) {
+                std::lock_guard lock(orphanMtx);
+                orphans.push_back(currentCache);
+                currentCache = nullptr;
+            }
+        }
+    };
+
+    thread_local CacheOwner cacheOwner;
+
+    ThreadCache* threadCache() {
+        if (!currentCache && !cacheDestroyed) {
+            // touch the owner, so that the cache is given up when the thread exits
+            (void) &cacheOwner;
+            currentCache = acquireCache();
+        }
+
+        return currentCache;
+    }
+
+    void* allocateUnpooled(size_t size) {
+        auto header = static_cast<BlockHeader*>(::operator new(sizeof(BlockHeader) + size));
+        header->owner = nullptr;
+        header->sizeClass = UNPOOLED;
+        return userOf(header);
+    }
+}
+
+void* allocateFuture(size_t size) {
+    size_t cls = (size + CLASS_STEP - 1) / CLASS_STEP - 1;
+    auto cache = threadCache();
+
+    if (cls >= CLASS_COUNT || !cache) {
+        return allocateUnpooled(size);
+    }
+
+    if (!cache->local[cls]) {
+        drainRemote(cache);
+    }
+
+    if (auto node = cache->local[cls]) {
+        cache->local[cls] = node->next;
+        cache->localCount[cls]--;
+        return node;
+    }
+
+    auto header = static_cast<BlockHeader*>(::operator new(sizeof(BlockHeader) + (cls + 1) * CLASS_STEP));
+    header->owner = cache;
+    header->sizeClass = cls;
+    return userOf(header);
+}
+
+void deallocateFuture(void* ptr) {
+    if (!ptr) return;
+
+    auto header = headerOf(ptr);
+    auto owner = header->owner;
+
+    if (header->sizeClass == UNPOOLED) {
+        ::operator delete(header);
+        return;
+    }
+
+    auto node = static_cast<FreeNode*>(ptr);
+    auto cls = header->sizeClass;
+
+    if (owner == currentCache) {
+        if (owner->localCount[cls] >= MAX_CACHED_PER_CLASS) {
+            ::operator delete(header);
+            return;
+        }
+
+        node->next = owner->local[cls];
+        owner->local[cls] = node;
+        owner->localCount[cls]++;
+        return;
+    }
+
+    // hand the block back to the thread that allocated it
+    auto head = owner->remote.load(std::memory_order::relaxed);
+    do {
+        node->next = head;
+    } while (!owner->remote.compare_exchange_weak(head, node, std::memory_order::release, std::memory_order::relaxed));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include <asp/async/MainThreadExecutor.hpp>
+#include <asp/detail/Detail.hpp>
+
+namespace asp::async {
+
+MainThreadExecutor& MainThreadExecutor::get() {
+    return asp::detail::leakedGlobal<MainThreadExecutor>();
+}
+
+MainThreadExecutor::MainThreadExecutor() {
+    auto dummy = new Node();
+    head->store(dummy, std::memory_order::relaxed);
+    *tail = dummy;
+}
+
+MainThreadExecutor::~MainThreadExecutor() {
+    Node* node = *tail;
+
+    while (node) {
+        Node* next = node->next.load(std::memory_order::acquire);
+        delete node;
+        node = next;
+    }
+}
+
+void MainThreadExecutor::post(std::function<void()>&& f) {
+    auto node = new Node();
+    node->job = std::move(f);
+
+    Node* prev = head->exchange(node, std::memory_order::acq_rel);
+
+    // until this store, the consumer sees the queue as ending at `prev`, so the node is picked up by a later drain
+    prev->next.store(node, std::memory_order::release);
+}
+
+bool MainThreadExecutor::pop(std::function<void()>& out) {
+    Node* last = *tail;
+    Node* next = last->next.load(std::memory_order::acquire);
+
+    if (!next) return false;
+
+    // `next` becomes the new dummy node
+    out = std::move(next->job);
+    *tail = next;
+    delete last;
+
+    return true;
+}
+
+size_t MainThreadExecutor::drain() {
+    size_t count = 0;
+    std::function<void()> job;
+
+    while (this->pop(job)) {
+        job();
+        count++;
+    }
+
+    return count;
+}
+
+size_t MainThreadExecutor::drain(size_t maxTasks) {
+    size_t count = 0;
+    std::function<void()> job;
+
+    while (count < maxTasks && this->pop(job)) {
+        job();
+        count++;
+    }
+
+    return count;
+}
+
+size_t MainThreadExecutor::drain(std::chrono::nanoseconds budget) {
+    auto deadline = std::chrono::steady_clock::now() + budget;
+
+    size_t count = 0;
+    std::function<void()> job;
+
+    while (this->pop(job)) {
+        job();
+        count++;
+
+        if (std::chrono::steady_clock::now() >= deadline) break;
+    }
+
+    return count;
+}
+
+bool MainThreadExecutor::empty() const {
+    return (*tail)->next.load(std::memory_order::acquire) == nullptr;
+}
+
+}
\ No newline at end of file
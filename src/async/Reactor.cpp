@@ -0,0 +1,395 @@
+#ifdef __linux__
+
+#include <asp/async/Reactor.hpp>
+#include <asp/async/Executor.hpp>
+#include <asp/Log.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace asp::async {
+
+/* ReactorImpl declaration */
+class ReactorImpl {
+public:
+    ReactorImpl();
+    ~ReactorImpl();
+
+    void waitFor(int fd, Reactor::Interest interest, Reactor::Callback&& callback);
+    void deregister(int fd);
+
+private:
+    struct FdState {
+        std::vector<Reactor::Callback> readers;
+        std::vector<Reactor::Callback> writers;
+        bool added = false;
+    };
+
+    int epfd;
+    // written to wake up the reactor thread when it should stop
+    int wakeFd;
+    std::mutex mtx;
+    std::unordered_map<int, FdState> fds;
+    std::thread thread;
+    bool stopping = false;
+
+    void arm(int fd, FdState& state);
+    void run();
+};
+
+/* ReactorImpl implementation */
+
+ReactorImpl::ReactorImpl() {
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+    ASP_ALWAYS_ASSERT(epfd != -1, "failed to create an epoll instance");
+
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    ASP_ALWAYS_ASSERT(wakeFd != -1, "failed to create an eventfd");
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = wakeFd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, wakeFd, &ev);
+
+    thread = std::thread([this] { this->run(); });
+}
+
+ReactorImpl::~ReactorImpl() {
+    {
+        std::unique_lock lock(mtx);
+        stopping = true;
+    }
+
+    uint64_t one = 1;
+    (void) ::write(wakeFd, &one, sizeof(one));
+
+    thread.join();
+
+    ::close(wakeFd);
+    ::close(epfd);
+}
+
+// Must be called with `mtx` locked. Registers interest in the events that currently have waiters,
+// descriptors are armed in one-shot mode and re-armed after every event.
+void ReactorImpl::arm(int fd, FdState& state) {
+    epoll_event ev{};
+    ev.events = EPOLLONESHOT;
+    ev.data.fd = fd;
+
+    if (!state.readers.empty()) ev.events |= EPOLLIN | EPOLLRDHUP;
+    if (!state.writers.empty()) ev.events |= EPOLLOUT;
+
+    int op = state.added ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+
+    if (epoll_ctl(epfd, op, fd, &ev) == -1) {
+        throw std::system_error(errno, std::generic_category(), "epoll_ctl");
+    }
+
+    state.added = true;
+}
+
+void ReactorImpl::waitFor(int fd, Reactor::Interest interest, Reactor::Callback&& callback) {
+    std::unique_lock lock(mtx);
+
+    auto& state = fds[fd];
+    auto& waiters = interest == Reactor::Interest::Read ? state.readers : state.writers;
+
+    waiters.push_back(std::move(callback));
+
+    try {
+        this->arm(fd, state);
+    } catch (...) {
+        // the caller gets the error instead, so the callback must never be called
+        waiters.pop_back();
+
+        if (!state.added && state.readers.empty() && state.writers.empty()) {
+            fds.erase(fd);
+        }
+
+        throw;
+    }
+}
+
+void ReactorImpl::deregister(int fd) {
+    FdState state;
+
+    {
+        std::unique_lock lock(mtx);
+
+        auto it = fds.find(fd);
+        if (it == fds.end()) return;
+
+        state = std::move(it->second);
+        fds.erase(it);
+
+        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    for (auto& cb : state.readers) cb(true);
+    for (auto& cb : state.writers) cb(true);
+}
+
+void ReactorImpl::run() {
+    epoll_event events[64];
+    std::vector<Reactor::Callback> ready;
+
+    while (true) {
+        int n = epoll_wait(epfd, events, 64, -1);
+
+        if (n == -1) {
+            if (errno == EINTR) continue;
+
+            asp::log(LogLevel::Error, std::string("epoll_wait failed: ") + std::strerror(errno));
+            return;
+        }
+
+        {
+            std::unique_lock lock(mtx);
+
+            if (stopping) return;
+
+            for (int i = 0; i < n; i++) {
+                int fd = events[i].data.fd;
+                auto ev = events[i].events;
+
+                if (fd == wakeFd) continue;
+
+                auto it = fds.find(fd);
+                if (it == fds.end()) continue;
+
+                auto& state = it->second;
+                bool failed = ev & (EPOLLERR | EPOLLHUP);
+
+                if (failed || (ev & (EPOLLIN | EPOLLRDHUP))) {
+                    std::move(state.readers.begin(), state.readers.end(), std::back_inserter(ready));
+                    state.readers.clear();
+                }
+
+                if (failed || (ev & EPOLLOUT)) {
+                    std::move(state.writers.begin(), state.writers.end(), std::back_inserter(ready));
+                    state.writers.clear();
+                }
+
+                if (!state.readers.empty() || !state.writers.empty()) {
+                    try {
+                        this->arm(fd, state);
+                    } catch (const std::exception& e) {
+                        asp::log(LogLevel::Error, std::string("failed to re-arm a file descriptor: ") + e.what());
+                    }
+                }
+            }
+        }
+
+        for (auto& cb : ready) {
+            cb(false);
+        }
+
+        ready.clear();
+    }
+}
+
+/* Reactor implementation */
+
+Reactor::Reactor() : impl(std::make_unique<ReactorImpl>()) {}
+
+Reactor::~Reactor() {}
+
+Reactor& Reactor::get() {
+    static Reactor reactor;
+    return reactor;
+}
+
+void Reactor::waitFor(int fd, Interest interest, Callback&& callback) {
+    impl->waitFor(fd, interest, std::move(callback));
+}
+
+FutureHandle<void> Reactor::ready(int fd, Interest interest) {
+    Promise<void> promise;
+
+    this->waitFor(fd, interest, [promise](bool cancelled) {
+        if (cancelled) {
+            promise.reject(std::system_error(ECANCELED, std::generic_category(), "file descriptor was deregistered"));
+        } else {
+            promise.resolve();
+        }
+    });
+
+    return promise.getFuture();
+}
+
+void Reactor::deregister(int fd) {
+    impl->deregister(fd);
+}
+
+/* I/O functions */
+
+namespace {
+    // Retries `attempt` every time `fd` becomes ready, until it returns something other than `EAGAIN`.
+    // Each retry is ran on the executor of the calling thread (see `currentExecutor()`) rather than on the reactor thread,
+    // so the operation completes on the runtime it was started from. If `fd` is deregistered while waiting,
+    // fails with `ECANCELED` without calling `attempt` again, as the descriptor may already be closed or reused.
+    // If `waitFirst` is set, `attempt` is only called once `fd` has become ready for the first time.
+    template <typename T, typename F>
+    FutureHandle<T> retryWhenReady(int fd, Reactor::Interest interest, F&& attempt, bool waitFirst = false) {
+        struct Op : std::enable_shared_from_this<Op> {
+            int fd;
+            Reactor::Interest interest;
+            std::decay_t<F> attempt;
+            Executor& executor;
+            Promise<T> promise;
+
+            Op(int fd, Reactor::Interest interest, F&& attempt)
+                : fd(fd), interest(interest), attempt(std::forward<F>(attempt)), executor(currentExecutor()) {}
+
+            void run() {
+                try {
+                    if (!this->attempt(promise)) {
+                        this->wait();
+                    }
+                } catch (const std::exception& e) {
+                    promise.reject(e);
+                }
+            }
+
+            void wait() {
+                Reactor::get().waitFor(fd, interest, [self = this->shared_from_this()](bool cancelled) {
+                    if (cancelled) {
+                        self->promise.reject(std::system_error(ECANCELED, std::generic_category(), "file descriptor was deregistered"));
+                        return;
+                    }
+
+                    self->executor.execute([self] {
+                        self->run();
+                    });
+                });
+            }
+        };
+
+        auto op = std::make_shared<Op>(fd, interest, std::forward<F>(attempt));
+        auto handle = op->promise.getFuture();
+
+        if (waitFirst) {
+            try {
+                op->wait();
+            } catch (const std::exception& e) {
+                op->promise.reject(e);
+            }
+        } else {
+            op->run();
+        }
+
+        return handle;
+    }
+
+    bool wouldBlock(int err) {
+        return err == EAGAIN || err == EWOULDBLOCK;
+    }
+
+    [[noreturn]] void throwErrno(int err, const char* what) {
+        throw std::system_error(err, std::generic_category(), what);
+    }
+}
+
+FutureHandle<size_t> asyncRead(int fd, void* buf, size_t len) {
+    return retryWhenReady<size_t>(fd, Reactor::Interest::Read, [fd, buf, len](const Promise<size_t>& promise) {
+        while (true) {
+            ssize_t n = ::read(fd, buf, len);
+
+            if (n >= 0) {
+                promise.resolve(static_cast<size_t>(n));
+                return true;
+            }
+
+            if (errno == EINTR) continue;
+            if (wouldBlock(errno)) return false;
+
+            throwErrno(errno, "read");
+        }
+    });
+}
+
+FutureHandle<size_t> asyncWrite(int fd, const void* buf, size_t len) {
+    return retryWhenReady<size_t>(fd, Reactor::Interest::Write, [fd, buf, len](const Promise<size_t>& promise) {
+        while (true) {
+            ssize_t n = ::write(fd, buf, len);
+
+            if (n >= 0) {
+                promise.resolve(static_cast<size_t>(n));
+                return true;
+            }
+
+            if (errno == EINTR) continue;
+            if (wouldBlock(errno)) return false;
+
+            throwErrno(errno, "write");
+        }
+    });
+}
+
+FutureHandle<int> asyncAccept(int fd) {
+    return retryWhenReady<int>(fd, Reactor::Interest::Read, [fd](const Promise<int>& promise) {
+        while (true) {
+            int client = ::accept4(fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+            if (client != -1) {
+                promise.resolve(client);
+                return true;
+            }
+
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (wouldBlock(errno)) return false;
+
+            throwErrno(errno, "accept");
+        }
+    });
+}
+
+FutureHandle<void> asyncConnect(int fd, const sockaddr* addr, socklen_t addrlen) {
+    int res;
+
+    do {
+        res = ::connect(fd, addr, addrlen);
+    } while (res == -1 && errno == EINTR);
+
+    if (res == 0) {
+        Promise<void> promise;
+        promise.resolve();
+        return promise.getFuture();
+    }
+
+    if (errno != EINPROGRESS) {
+        Promise<void> promise;
+        promise.reject(std::system_error(errno, std::generic_category(), "connect"));
+        return promise.getFuture();
+    }
+
+    // the result of a non-blocking connect is reported once the socket becomes writable, `SO_ERROR` reads 0 while the
+    // connection is still pending, so it must not be checked before that
+    return retryWhenReady<void>(fd, Reactor::Interest::Write, [fd](const Promise<void>& promise) {
+        int err = 0;
+        socklen_t errlen = sizeof(err);
+
+        if (::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errlen) == -1) {
+            throwErrno(errno, "getsockopt");
+        }
+
+        if (err == EINPROGRESS || err == EALREADY) return false;
+        if (err != 0) throwErrno(err, "connect");
+
+        promise.resolve();
+        return true;
+    }, true);
+}
+
+}
+
+#endif
\ No newline at end of file
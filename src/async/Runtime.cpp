@@ -1,39 +1,196 @@
 #include <asp/async/Runtime.hpp>
+#include <asp/detail/Detail.hpp>
 #include <asp/sync/Atomic.hpp>
+#include <asp/thread/ElasticThreadPool.hpp>
 #include <asp/thread/ThreadPool.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <thread>
 
 namespace asp::async {
 
 static constexpr RuntimeSettings DEFAULT_SETTINGS = {
-    .threadCount = 0
+    .threadCount = 0,
+    .autoLaunch = false,
+    .maxBlockingThreads = 512,
+    .blockingIdleTimeout = std::chrono::seconds(10),
+    .currentThread = false,
 };
 
 /* RuntimeImpl declaration */
 class RuntimeImpl {
 public:
-    RuntimeImpl(const RuntimeSettings& settings) : settings(settings) {}
+    RuntimeImpl(Runtime& runtime, const RuntimeSettings& settings)
+        : runtime(runtime), settings(settings), token(std::make_shared<std::atomic<RuntimeImpl*>>(this)), blockingExecutor(this) {}
+    ~RuntimeImpl();
 
     void launch();
     void runAsync(std::function<void()>&& f);
+    void runBlocking(std::function<void()>&& f);
+
+    // current-thread mode
+    bool runLocalTask();
+    void runLocalUntil(const std::function<bool()>& done);
+    // Sets `done` and wakes up the owner, `done` must only be read by `runLocalUntil`.
+    void wakeLocal(bool& done);
 
 private:
     friend class Runtime;
+    friend class detail::LocalWaiter;
+    friend Executor& currentExecutor();
 
+    Runtime& runtime;
     RuntimeSettings settings;
     std::unique_ptr<thread::ThreadPool> tpool;
+    // published once the runtime is launched, so that spawning does not need to lock `mtx`
+    std::atomic<thread::ThreadPool*> pool = nullptr;
     std::mutex mtx;
-    sync::AtomicBool launched = false;
+
+    // queue of a runtime in current-thread mode, tasks can still be pushed from any thread
+    sync::AtomicBool localLaunched = false;
+    // the thread that drives the queue, claimed by `launch()` or by the first call that runs tasks, guarded by `localMtx`
+    std::thread::id owner;
+    // referenced by the owner thread and cleared on destruction, see `currentThreadRuntime()`
+    std::shared_ptr<std::atomic<RuntimeImpl*>> token;
+    std::mutex localMtx;
+    std::condition_variable localCv;
+    std::deque<std::function<void()>> localTasks;
+    bool localWoken = false;
+
+    // created on the first call to `spawnBlocking`
+    std::unique_ptr<thread::ElasticThreadPool> blockingPool;
+    std::atomic<thread::ElasticThreadPool*> blockingPoolPtr = nullptr;
+
+    struct BlockingExecutor : public Executor {
+        RuntimeImpl* impl;
+
+        BlockingExecutor(RuntimeImpl* impl) : impl(impl) {}
+
+        void execute(std::function<void()>&& f) override {
+            impl->runBlocking(std::move(f));
+        }
+    } blockingExecutor;
+
+    void launchLocked(bool claim);
+    thread::ThreadPool* launchedPool();
+    void claimOwner();
 };
 
+// Token of the current-thread runtime driven by this thread, whose tasks are ran while waiting on a future.
+// The runtime may be destroyed by another thread, which cannot reach this thread local, so it clears the token instead.
+static thread_local std::shared_ptr<std::atomic<RuntimeImpl*>> currentThreadToken;
+
+static RuntimeImpl* currentThreadRuntime() {
+    return currentThreadToken ? currentThreadToken->load(std::memory_order::acquire) : nullptr;
+}
+
+bool detail::ownsCurrentThreadRuntime() {
+    return currentThreadRuntime() != nullptr;
+}
+
+bool detail::runCurrentThreadTask() {
+    auto rt = currentThreadRuntime();
+    return rt && rt->runLocalTask();
+}
+
+detail::LocalWaiter::LocalWaiter() : runtime(currentThreadRuntime()) {}
+
+void detail::LocalWaiter::onComplete() {
+    runtime->wakeLocal(done);
+}
+
+void detail::LocalWaiter::wait() {
+    runtime->runLocalUntil([this] {
+        return done;
+    });
+}
+
+namespace {
+    // Runtimes that own each launched thread pool, so that worker threads can find the runtime they belong to.
+    struct PoolOwners {
+        std::mutex mtx;
+        std::unordered_map<thread::ThreadPool*, Runtime*> map;
+    };
+
+    PoolOwners& poolOwners() {
+        return asp::detail::leakedGlobal<PoolOwners>();
+    }
+}
+
+Executor& currentExecutor() {
+    if (auto rt = currentThreadRuntime()) {
+        return rt->runtime;
+    }
+
+    if (auto pool = thread::ThreadPool::current()) {
+        // a worker belongs to the same pool for its whole lifetime, so it only has to be looked up once
+        static thread_local bool lookedUp = false;
+        static thread_local Runtime* owner = nullptr;
+
+        if (!lookedUp) {
+            auto& owners = poolOwners();
+            std::lock_guard lock(owners.mtx);
+
+            auto it = owners.map.find(pool);
+            owner = it == owners.map.end() ? nullptr : it->second;
+            lookedUp = true;
+        }
+
+        if (owner) return *owner;
+    }
+
+    return InlineExecutor::get();
+}
+
 /* RuntimeImpl implementation */
 
+RuntimeImpl::~RuntimeImpl() {
+    // the thread local of the owner is left alone, it may already be destroyed if this runs during static destruction
+    token->store(nullptr, std::memory_order::release);
+
+    // Members are destroyed in reverse order, which would tear down the blocking executor while workers may still be
+    // running tasks that call `spawnBlocking`. Finish and stop everything explicitly instead, starting with the workers.
+    if (tpool) {
+        auto p = tpool.get();
+        tpool.reset();
+        pool.store(nullptr, std::memory_order::release);
+
+        auto& owners = poolOwners();
+        std::lock_guard lock(owners.mtx);
+        owners.map.erase(p);
+    }
+
+    // like the thread pool, finish everything that is still queued
+    while (this->runLocalTask()) {}
+
+    blockingPool.reset();
+    blockingPoolPtr.store(nullptr, std::memory_order::release);
+}
+
 void RuntimeImpl::launch() {
     std::unique_lock lock(mtx);
+    this->launchLocked(true);
+}
+
+// `claim` is false when launched by `autoLaunch`, as the spawning thread is not necessarily the one that will run the tasks.
+void RuntimeImpl::launchLocked(bool claim) {
+    ASP_ALWAYS_ASSERT(!pool.load(std::memory_order::relaxed) && !localLaunched.load(), "cannot launch the same instance of Runtime twice");
 
-    ASP_ALWAYS_ASSERT(!launched, "cannot launch the same instance of Runtime twice");
+    if (settings.currentThread) {
+        localLaunched.store(true);
+
+        if (claim) {
+            this->claimOwner();
+        }
+
+        asp::trace("async runtime launched in current-thread mode");
+        return;
+    }
 
     if (settings.threadCount == 0) {
         settings.threadCount = std::thread::hardware_concurrency();
@@ -44,30 +201,163 @@ void RuntimeImpl::launch() {
 
     tpool = std::make_unique<thread::ThreadPool>(settings.threadCount);
 
-    launched = true;
+    {
+        auto& owners = poolOwners();
+        std::lock_guard lock(owners.mtx);
+        owners.map[tpool.get()] = &runtime;
+    }
+    pool.store(tpool.get(), std::memory_order::release);
 
     asp::trace("async runtime launched");
 }
 
-void RuntimeImpl::runAsync(std::function<void()>&& f) {
+// Slow path of `runAsync`, taken only while the runtime has not been launched yet.
+thread::ThreadPool* RuntimeImpl::launchedPool() {
     std::unique_lock lock(mtx);
 
-    ASP_ALWAYS_ASSERT(launched, "cannot launch a task on a Runtime that isn't running");
+    if (auto p = pool.load(std::memory_order::acquire)) {
+        return p;
+    }
+
+    if (localLaunched.load()) {
+        return nullptr;
+    }
+
+    ASP_ALWAYS_ASSERT(settings.autoLaunch, "cannot launch a task on a Runtime that isn't running");
+
+    this->launchLocked(false);
+
+    return tpool.get();
+}
+
+void RuntimeImpl::runAsync(std::function<void()>&& f) {
+    auto p = pool.load(std::memory_order::acquire);
+
+    if (!p && !localLaunched.load()) {
+        p = this->launchedPool();
+    }
+
+    if (p) {
+        p->pushTask(std::move(f));
+        return;
+    }
+
+    {
+        std::lock_guard lock(localMtx);
+        localTasks.push_back(std::move(f));
+    }
+
+    localCv.notify_one();
+}
+
+bool RuntimeImpl::runLocalTask() {
+    std::unique_lock lock(localMtx);
+
+    if (localTasks.empty()) return false;
+
+    auto task = std::move(localTasks.front());
+    localTasks.pop_front();
+    lock.unlock();
+
+    task();
+
+    return true;
+}
+
+void RuntimeImpl::runLocalUntil(const std::function<bool()>& done) {
+    this->claimOwner();
+
+    std::unique_lock lock(localMtx);
+
+    while (!done()) {
+        if (localTasks.empty()) {
+            localCv.wait(lock, [this] { return !localTasks.empty() || localWoken; });
+            localWoken = false;
+            continue;
+        }
+
+        auto task = std::move(localTasks.front());
+        localTasks.pop_front();
+        lock.unlock();
+
+        task();
+
+        lock.lock();
+    }
+}
 
-    tpool->pushTask(std::move(f));
+void RuntimeImpl::wakeLocal(bool& done) {
+    // notified under the lock, as the owner may destroy the runtime as soon as it sees `done`
+    std::lock_guard lock(localMtx);
+    done = true;
+    localWoken = true;
+    localCv.notify_one();
+}
+
+// Makes the calling thread the owner if there is none yet, otherwise asserts that it already is the owner.
+void RuntimeImpl::claimOwner() {
+    ASP_ALWAYS_ASSERT(localLaunched.load(), "runtime is not running in current-thread mode");
+
+    std::unique_lock lock(localMtx);
+
+    if (owner == std::thread::id{}) {
+        owner = std::this_thread::get_id();
+        currentThreadToken = token;
+    }
+
+    ASP_ALWAYS_ASSERT(owner == std::this_thread::get_id(), "tasks of a current-thread runtime must be ran by the thread that first ran them");
+}
+
+void RuntimeImpl::runBlocking(std::function<void()>&& f) {
+    auto p = blockingPoolPtr.load(std::memory_order::acquire);
+
+    if (!p) {
+        std::unique_lock lock(mtx);
+
+        if (!blockingPool) {
+            blockingPool = std::make_unique<thread::ElasticThreadPool>(settings.maxBlockingThreads, settings.blockingIdleTimeout);
+            blockingPoolPtr.store(blockingPool.get(), std::memory_order::release);
+        }
+
+        p = blockingPool.get();
+    }
+
+    p->pushTask(std::move(f));
 }
 
 /* Runtime implementation */
 
-Runtime::Runtime() : impl(std::make_unique<RuntimeImpl>(DEFAULT_SETTINGS)) {}
+Runtime::Runtime() : impl(std::make_unique<RuntimeImpl>(*this, DEFAULT_SETTINGS)) {}
+
+Runtime::Runtime(const RuntimeSettings& settings) : impl(std::make_unique<RuntimeImpl>(*this, settings)) {}
+
+Runtime::~Runtime() {}
 
 Runtime& Runtime::get() {
     static Runtime runtime;
     return runtime;
 }
 
+Runtime& Runtime::named(std::string_view name) {
+    static std::mutex mtx;
+    static std::unordered_map<std::string, std::unique_ptr<Runtime>> runtimes;
+
+    std::unique_lock lock(mtx);
+
+    auto it = runtimes.find(std::string(name));
+    if (it != runtimes.end()) {
+        return *it->second;
+    }
+
+    auto& rt = runtimes[std::string(name)];
+    rt = std::unique_ptr<Runtime>(new Runtime());
+    return *rt;
+}
+
 void Runtime::configure(const RuntimeSettings& settings) {
-    ASP_ALWAYS_ASSERT(!impl->launched, "cannot configure a runtime after it has been launched");
+    std::unique_lock lock(impl->mtx);
+
+    ASP_ALWAYS_ASSERT(!impl->pool.load(std::memory_order::relaxed), "cannot configure a runtime after it has been launched");
     impl->settings = settings;
 }
 
@@ -75,8 +365,53 @@ void Runtime::launch() {
     impl->launch();
 }
 
+void Runtime::execute(std::function<void()>&& f) {
+    impl->runAsync(std::move(f));
+}
+
+Executor& Runtime::blockingExecutor() {
+    return impl->blockingExecutor;
+}
+
+void Runtime::enableWatchdog(thread::WatchdogSettings settings) {
+    auto p = impl->pool.load(std::memory_order::acquire);
+    ASP_ALWAYS_ASSERT(p, "cannot enable the watchdog on a Runtime that isn't running");
+
+    p->enableWatchdog(std::move(settings));
+}
+
+void Runtime::disableWatchdog() {
+    if (auto p = impl->pool.load(std::memory_order::acquire)) {
+        p->disableWatchdog();
+    }
+}
+
+uint64_t Runtime::stallCount() const {
+    auto p = impl->pool.load(std::memory_order::acquire);
+    return p ? p->stallCount() : 0;
+}
+
+size_t Runtime::runUntilIdle() {
+    impl->claimOwner();
+
+    size_t count = 0;
+    while (impl->runLocalTask()) {
+        count++;
+    }
+
+    return count;
+}
+
 void Runtime::runAsync(std::function<void()>&& f) {
     impl->runAsync(std::move(f));
 }
 
+void Runtime::runLocalUntil(const std::function<bool()>& done) {
+    impl->runLocalUntil(done);
+}
+
+void Runtime::wakeLocal(bool& done) {
+    impl->wakeLocal(done);
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include <asp/async/Timer.hpp>
+
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace asp::async {
+
+/* TimerServiceImpl declaration */
+class TimerServiceImpl {
+public:
+    TimerServiceImpl();
+    ~TimerServiceImpl();
+
+    TimerService::TimerId schedule(TimerService::Clock::time_point deadline, std::function<void()>&& callback);
+    bool cancel(TimerService::TimerId id);
+
+private:
+    struct Entry {
+        TimerService::Clock::time_point deadline;
+        TimerService::TimerId id;
+
+        bool operator>(const Entry& other) const {
+            return deadline > other.deadline;
+        }
+    };
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+    // callbacks are kept outside of the heap, so that cancelling a timer releases its callback right away
+    std::unordered_map<TimerService::TimerId, std::function<void()>> callbacks;
+    TimerService::TimerId nextId = 1;
+    bool stopping = false;
+    std::thread thread;
+
+    void run();
+};
+
+/* TimerServiceImpl implementation */
+
+TimerServiceImpl::TimerServiceImpl() {
+    thread = std::thread([this] { this->run(); });
+}
+
+TimerServiceImpl::~TimerServiceImpl() {
+    {
+        std::unique_lock lock(mtx);
+        stopping = true;
+    }
+
+    cv.notify_one();
+    thread.join();
+}
+
+TimerService::TimerId TimerServiceImpl::schedule(TimerService::Clock::time_point deadline, std::function<void()>&& callback) {
+    std::unique_lock lock(mtx);
+
+    auto id = nextId++;
+    bool earliest = heap.empty() || deadline < heap.top().deadline;
+
+    heap.push(Entry { deadline, id });
+    callbacks.emplace(id, std::move(callback));
+
+    lock.unlock();
+
+    // only wake the thread if it is sleeping until a later deadline
+    if (earliest) {
+        cv.notify_one();
+    }
+
+    return id;
+}
+
+bool TimerServiceImpl::cancel(TimerService::TimerId id) {
+    std::function<void()> callback;
+
+    std::unique_lock lock(mtx);
+
+    auto it = callbacks.find(id);
+    if (it == callbacks.end()) return false;
+
+    // destroy the callback outside of the lock
+    callback = std::move(it->second);
+    callbacks.erase(it);
+
+    // cancelled entries stay in the heap until their deadline, rebuild it if they start to pile up
+    if (heap.size() > 64 && heap.size() > callbacks.size() * 2) {
+        std::vector<Entry> live;
+        live.reserve(callbacks.size());
+
+        while (!heap.empty()) {
+            if (callbacks.contains(heap.top().id)) {
+                live.push_back(heap.top());
+            }
+
+            heap.pop();
+        }
+
+        heap = decltype(heap)(std::greater<Entry>{}, std::move(live));
+    }
+
+    lock.unlock();
+
+    return true;
+}
+
+void TimerServiceImpl::run() {
+    std::vector<std::function<void()>> due;
+    std::unique_lock lock(mtx);
+
+    while (!stopping) {
+        if (heap.empty()) {
+            cv.wait(lock);
+            continue;
+        }
+
+        auto now = TimerService::Clock::now();
+        auto next = heap.top().deadline;
+
+        if (next > now) {
+            cv.wait_until(lock, next);
+            continue;
+        }
+
+        while (!heap.empty() && heap.top().deadline <= now) {
+            auto it = callbacks.find(heap.top().id);
+            heap.pop();
+
+            // cancelled timers are left in the heap and skipped here
+            if (it == callbacks.end()) continue;
+
+            due.push_back(std::move(it->second));
+            callbacks.erase(it);
+        }
+
+        lock.unlock();
+
+        for (auto& cb : due) {
+            cb();
+        }
+
+        due.clear();
+
+        lock.lock();
+    }
+}
+
+/* TimerService implementation */
+
+TimerService::TimerService() : impl(std::make_unique<TimerServiceImpl>()) {}
+
+TimerService::~TimerService() {}
+
+TimerService& TimerService::get() {
+    static TimerService service;
+    return service;
+}
+
+TimerService::TimerId TimerService::schedule(Clock::time_point deadline, std::function<void()>&& callback) {
+    return impl->schedule(deadline, std::move(callback));
+}
+
+bool TimerService::cancel(TimerId id) {
+    return impl->cancel(id);
+}
+
+/* Futures */
+
+FutureHandle<void> sleepUntil(TimerService::Clock::time_point deadline, Executor& executor) {
+    Promise<void> promise;
+
+    // resolve on the executor rather than on the timer thread, as awaiting coroutines are resumed by whoever completes the future
+    TimerService::get().schedule(deadline, [promise, &executor] {
+        executor.execute([promise] {
+            promise.resolve();
+        });
+    });
+
+    return promise.getFuture();
+}
+
+}
\ No newline at end of file
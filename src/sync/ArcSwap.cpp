@@ -0,0 +1,76 @@
+#include <asp/sync/ArcSwap.hpp>
+#include <asp/sync/CachePadded.hpp>
+#include <asp/sync/ShardedCounter.hpp>
+
+#include <algorithm>
+#include <thread>
+
+namespace asp::detail {
+
+namespace {
+    struct HazardDomain {
+        std::unique_ptr<sync::CachePadded<std::atomic<void*>>[]> slots;
+        size_t mask;
+
+        HazardDomain() {
+            // a few slots per hardware thread, so that readers almost never have to probe
+            size_t count = std::max<size_t>(defaultShardCount() * 4, 64);
+
+            slots = std::make_unique<sync::CachePadded<std::atomic<void*>>[]>(count);
+            mask = count - 1;
+
+            for (size_t i = 0; i < count; i++) {
+                slots[i]->store(nullptr, std::memory_order::relaxed);
+            }
+        }
+    };
+
+    HazardDomain& domain() {
+        static HazardDomain domain;
+        return domain;
+    }
+}
+
+std::atomic<void*>* protectHazard(const std::atomic<void*>& src, void*& out) {
+    auto& d = domain();
+
+    for (size_t i = threadShardIndex();; i++) {
+        auto& slot = *d.slots[i & d.mask];
+
+        void* ptr = src.load(std::memory_order::acquire);
+        void* expected = nullptr;
+
+        if (!slot.compare_exchange_strong(expected, ptr, std::memory_order::seq_cst, std::memory_order::relaxed)) {
+            // slot is taken by another reader
+            continue;
+        }
+
+        // the value could've been swapped and freed before our slot became visible, so check again
+        while (true) {
+            void* now = src.load(std::memory_order::seq_cst);
+            if (now == ptr) {
+                out = ptr;
+                return &slot;
+            }
+
+            ptr = now;
+            slot.store(ptr, std::memory_order::seq_cst);
+        }
+    }
+}
+
+void releaseHazard(std::atomic<void*>* slot) {
+    slot->store(nullptr, std::memory_order::release);
+}
+
+void waitForReaders(void* ptr) {
+    auto& d = domain();
+
+    for (size_t i = 0; i <= d.mask; i++) {
+        while (d.slots[i]->load(std::memory_order::seq_cst) == ptr) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include <asp/sync/ShardedCounter.hpp>
+
+#include <algorithm>
+#include <thread>
+
+namespace asp::detail {
+    size_t nextThreadShardIndex() {
+        static std::atomic<size_t> counter = 0;
+        return counter.fetch_add(1, std::memory_order::relaxed);
+    }
+
+    size_t defaultShardCount() {
+        return roundShardCount(std::thread::hardware_concurrency());
+    }
+}
+
+namespace asp::sync {
+
+static size_t shardCountFor(size_t shards) {
+    return shards == 0 ? detail::defaultShardCount() : detail::roundShardCount(shards);
+}
+
+/* ShardedCounter */
+
+ShardedCounter::ShardedCounter(size_t shards) {
+    size_t count = shardCountFor(shards);
+
+    slots = std::make_unique<CachePadded<AtomicU64>[]>(count);
+    mask = count - 1;
+}
+
+uint64_t ShardedCounter::load() const {
+    uint64_t total = 0;
+
+    for (size_t i = 0; i <= mask; i++) {
+        total += slots[i]->load();
+    }
+
+    return total;
+}
+
+void ShardedCounter::reset() {
+    for (size_t i = 0; i <= mask; i++) {
+        slots[i]->store(0);
+    }
+}
+
+/* ShardedSummary */
+
+ShardedSummary::ShardedSummary(size_t shards) {
+    size_t count = shardCountFor(shards);
+
+    slots = std::make_unique<CachePadded<Slot>[]>(count);
+    mask = count - 1;
+}
+
+ShardedSummary::Snapshot ShardedSummary::load() const {
+    Snapshot snap = {
+        .count = 0,
+        .sum = 0,
+        .min = INT64_MAX,
+        .max = INT64_MIN,
+    };
+
+    for (size_t i = 0; i <= mask; i++) {
+        auto& slot = *slots[i];
+
+        snap.count += slot.count.load();
+        snap.sum += slot.sum.load();
+        snap.min = std::min(snap.min, slot.min.load());
+        snap.max = std::max(snap.max, slot.max.load());
+    }
+
+    return snap;
+}
+
+void ShardedSummary::reset() {
+    for (size_t i = 0; i <= mask; i++) {
+        auto& slot = *slots[i];
+
+        slot.count.store(0);
+        slot.sum.store(0);
+        slot.min.store(INT64_MAX);
+        slot.max.store(INT64_MIN);
+    }
+}
+
+}
\ No newline at end of file
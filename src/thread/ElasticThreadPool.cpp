@@ -0,0 +1,119 @@
+#include <asp/thread/ElasticThreadPool.hpp>
+#include <asp/thread/Tracer.hpp>
+#include <asp/Log.hpp>
+
+namespace asp::thread {
+
+ElasticThreadPool::ElasticThreadPool(size_t maxThreads, std::chrono::milliseconds idleTimeout)
+    : maxThreads(maxThreads), idleTimeout(idleTimeout)
+{
+    ASP_ALWAYS_ASSERT(maxThreads != 0, "cannot create an ElasticThreadPool with no threads");
+}
+
+ElasticThreadPool::~ElasticThreadPool() {
+    std::unique_lock lock(mtx);
+
+    stopping = true;
+    taskCv.notify_all();
+
+    exitCv.wait(lock, [this] { return workers.empty(); });
+
+    auto finished = std::move(exited);
+    lock.unlock();
+
+    for (auto& thread : finished) {
+        thread.join();
+    }
+}
+
+void ElasticThreadPool::pushTask(const Task& task) {
+    this->push(Task(task));
+}
+
+void ElasticThreadPool::pushTask(Task&& task) {
+    this->push(std::move(task));
+}
+
+size_t ElasticThreadPool::threadCount() {
+    std::unique_lock lock(mtx);
+    return workers.size();
+}
+
+void ElasticThreadPool::push(Task&& task) {
+    std::unique_lock lock(mtx);
+
+    ASP_ALWAYS_ASSERT(!stopping, "cannot push a task to an ElasticThreadPool that is being destroyed");
+
+    queue.push_back(std::move(task));
+
+    // only grow if there aren't enough idle threads to pick up every queued task
+    if (queue.size() > idle && workers.size() < maxThreads) {
+        auto it = workers.emplace(workers.end());
+
+        it->setStartFunction([] {
+            if (Tracer::enabled()) {
+                Tracer::setThreadName("asp blocking worker");
+            }
+        });
+
+        it->setLoopFunction([this, &self = *it] {
+            this->runNext(self);
+        });
+
+        it->setTerminationFunction([this, it] {
+            std::unique_lock lock(mtx);
+
+            // the handle is joined either by the next push or by the destructor
+            exited.splice(exited.end(), workers, it);
+            exitCv.notify_all();
+        });
+
+        it->start();
+    } else {
+        taskCv.notify_one();
+    }
+
+    // clean up threads that have timed out
+    auto finished = std::move(exited);
+    exited.clear();
+    lock.unlock();
+
+    for (auto& thread : finished) {
+        thread.join();
+    }
+}
+
+// One iteration of a worker's loop. Runs the next task, or stops the worker once the pool is stopping or it has been idle for too long.
+void ElasticThreadPool::runNext(Thread<>& self) {
+    std::unique_lock lock(mtx);
+
+    if (queue.empty()) {
+        if (stopping) {
+            self.stop();
+            return;
+        }
+
+        idle++;
+        bool woken = taskCv.wait_for(lock, idleTimeout, [this] { return !queue.empty() || stopping; });
+        idle--;
+
+        if (!woken) {
+            self.stop();
+        }
+
+        return;
+    }
+
+    auto task = std::move(queue.front());
+    queue.pop_front();
+
+    lock.unlock();
+
+    try {
+        task();
+    } catch (const std::exception& e) {
+        asp::log(LogLevel::Error, std::string("unhandled exception from an ElasticThreadPool task: ") + e.what());
+    }
+}
+
+}
\ No newline at end of file
@@ -1,9 +1,29 @@
 #include <asp/thread/ThreadPool.hpp>
 #include <asp/Log.hpp>
 
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
 namespace asp::thread {
 
-ThreadPool::ThreadPool(size_t tc) {
+static thread_local ThreadPool* currentPool = nullptr;
+static thread_local size_t currentWorker = 0;
+static thread_local bool namedInTrace = false;
+
+static uint64_t steadyNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct ThreadPool::Watchdog {
+    WatchdogSettings settings;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stopping = false;
+    std::thread thread;
+};
+
+ThreadPool::ThreadPool(size_t tc) : slots(std::make_unique<sync::CachePadded<TaskSlot>[]>(tc)) {
 #ifdef ASP_ENABLE_FORMAT
     asp::trace("Creating ThreadPool with size {}", tc);
 #else
@@ -12,6 +32,11 @@ ThreadPool::ThreadPool(size_t tc) {
 
     for (size_t i = 0; i < tc; i++) {
         Thread<> thread;
+        thread.setStartFunction([this, i = i] {
+            currentPool = this;
+            currentWorker = i;
+        });
+
         thread.setLoopFunction([this, i = i] {
             auto& worker = this->workers.at(i);
 
@@ -19,11 +44,16 @@ ThreadPool::ThreadPool(size_t tc) {
 
             if (!task) return;
 
-            worker.doingWork = true;
+            worker.doingWork->store(true);
 
-            task.value()();
+            // whether the task is traced or watched was decided once when it was pushed
+            if (task->meta) [[unlikely]] {
+                this->runInstrumented(task.value(), &*this->slots[i]);
+            } else {
+                task->task();
+            }
 
-            worker.doingWork = false;
+            worker.doingWork->store(false);
         });
 
         Worker worker = {
@@ -41,6 +71,8 @@ ThreadPool::ThreadPool(size_t tc) {
 
 ThreadPool::~ThreadPool() {
     asp::trace("Destroying ThreadPool");
+    this->disableWatchdog();
+
     try {
         this->join();
 
@@ -60,11 +92,101 @@ ThreadPool::~ThreadPool() {
 }
 
 void ThreadPool::pushTask(const Task& task) {
-    taskQueue.push(task);
+    taskQueue.push(this->makeQueued(Task(task)));
 }
 
 void ThreadPool::pushTask(Task&& task) {
-    taskQueue.push(std::move(task));
+    taskQueue.push(this->makeQueued(std::move(task)));
+}
+
+ThreadPool::QueuedTask ThreadPool::makeQueued(Task&& task) {
+    QueuedTask queued {
+        .task = std::move(task),
+        .meta = nullptr,
+    };
+
+    // combined without short-circuiting, so that uninstrumented pushes take a single branch
+    if (Tracer::enabled() | watchdogActive.load()) [[unlikely]] {
+        queued.meta = std::make_unique<TaskMeta>(TaskMeta {
+            .label = TaskLabel::current(),
+            .id = 0,
+            .spawnTime = 0,
+            .dequeueTime = 0,
+            .spawnThread = 0,
+        });
+
+        if (Tracer::enabled()) {
+            queued.meta->id = Tracer::nextTaskId();
+            queued.meta->spawnTime = Tracer::now();
+            queued.meta->spawnThread = Tracer::threadId();
+        }
+    }
+
+    return queued;
+}
+
+// Slow path for tasks that carry metadata. `slot` is the watchdog slot of the worker, or `nullptr` when helping from a wait.
+void ThreadPool::runInstrumented(QueuedTask& task, TaskSlot* slot) {
+    if (task.meta->id != 0) {
+        task.meta->dequeueTime = Tracer::now();
+    }
+
+    // clears the slot even if the task throws
+    struct SlotGuard {
+        TaskSlot* slot = nullptr;
+
+        ~SlotGuard() {
+            if (slot) slot->start.store(0, std::memory_order::release);
+        }
+    } guard;
+
+    if (slot && watchdogActive.load()) {
+        slot->label.store(task.meta->label, std::memory_order::relaxed);
+        slot->start.store(steadyNanos(), std::memory_order::release);
+        guard.slot = slot;
+    }
+
+    runTraced(task);
+}
+
+void ThreadPool::runTraced(QueuedTask& task) {
+    auto& meta = *task.meta;
+
+    // only trace tasks that were pushed while tracing was enabled
+    if (meta.id == 0) {
+        task.task();
+        return;
+    }
+
+    if (currentPool && !namedInTrace) {
+        Tracer::setThreadName("asp worker " + std::to_string(currentWorker));
+        namedInTrace = true;
+    }
+
+    Tracer::TaskRecord record {
+        .id = meta.id,
+        .label = meta.label,
+        .spawnThread = meta.spawnThread,
+        .worker = Tracer::threadId(),
+        .spawnTime = meta.spawnTime,
+        .dequeueTime = meta.dequeueTime,
+        .startTime = 0,
+        .endTime = 0,
+    };
+
+    record.startTime = Tracer::now();
+
+    // record the task even if it throws
+    struct Finish {
+        Tracer::TaskRecord& record;
+
+        ~Finish() {
+            record.endTime = Tracer::now();
+            Tracer::record(record);
+        }
+    } finish{record};
+
+    task.task();
 }
 
 void ThreadPool::join() {
@@ -79,7 +201,7 @@ void ThreadPool::join() {
         std::this_thread::sleep_for(std::chrono::microseconds(200));
         stillWorking = false;
         for (const auto& worker : workers) {
-            if (worker.doingWork) {
+            if (worker.doingWork->load()) {
                 stillWorking = true;
                 break;
             }
@@ -91,7 +213,7 @@ bool ThreadPool::isDoingWork() {
     if (!taskQueue.empty()) return true;
 
     for (const auto& worker : workers) {
-        if (worker.doingWork) {
+        if (worker.doingWork->load()) {
             return true;
         }
     }
@@ -99,6 +221,24 @@ bool ThreadPool::isDoingWork() {
     return false;
 }
 
+bool ThreadPool::runPendingTask() {
+    auto task = taskQueue.tryPop();
+
+    if (!task) return false;
+
+    if (task->meta) [[unlikely]] {
+        this->runInstrumented(task.value(), nullptr);
+    } else {
+        task->task();
+    }
+
+    return true;
+}
+
+ThreadPool* ThreadPool::current() {
+    return currentPool;
+}
+
 void ThreadPool::setExceptionFunction(const std::function<void(const std::exception&)>& f) {
     onException = f;
 
@@ -107,4 +247,75 @@ void ThreadPool::setExceptionFunction(const std::function<void(const std::except
     }
 }
 
+void ThreadPool::enableWatchdog(WatchdogSettings settings) {
+    std::lock_guard guard(watchdogMtx);
+    this->stopWatchdog();
+
+    watchdog = std::make_unique<Watchdog>();
+    watchdog->settings = std::move(settings);
+    watchdogActive.store(true);
+
+    watchdog->thread = std::thread([this, wd = watchdog.get()] {
+        // start time of the task that was last reported on each worker, so that every stall is only reported once
+        std::vector<uint64_t> reported(workers.size(), 0);
+        uint64_t budget = std::chrono::duration_cast<std::chrono::nanoseconds>(wd->settings.budget).count();
+
+        std::unique_lock lock(wd->mtx);
+
+        while (!wd->cv.wait_for(lock, wd->settings.interval, [wd] { return wd->stopping; })) {
+            uint64_t now = steadyNanos();
+
+            for (size_t i = 0; i < workers.size(); i++) {
+                auto& slot = *slots[i];
+                uint64_t start = slot.start.load(std::memory_order::acquire);
+
+                if (start == 0 || start == reported[i] || now < start || now - start < budget) continue;
+
+                reported[i] = start;
+                stalls.fetchAdd(1);
+
+                StallInfo info {
+                    .worker = i,
+                    .label = slot.label.load(std::memory_order::relaxed),
+                    .elapsed = std::chrono::nanoseconds(now - start),
+                };
+
+                if (wd->settings.onStall) {
+                    wd->settings.onStall(info);
+                } else {
+                    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(info.elapsed).count();
+                    asp::log(LogLevel::Warn,
+                        "ThreadPool worker " + std::to_string(i) + " has been running task '" + (info.label ? info.label : "unnamed")
+                        + "' for " + std::to_string(ms) + "ms"
+                    );
+                }
+            }
+        }
+    });
+}
+
+void ThreadPool::disableWatchdog() {
+    std::lock_guard guard(watchdogMtx);
+    this->stopWatchdog();
+}
+
+void ThreadPool::stopWatchdog() {
+    if (!watchdog) return;
+
+    {
+        std::lock_guard lock(watchdog->mtx);
+        watchdog->stopping = true;
+    }
+
+    watchdog->cv.notify_one();
+    watchdog->thread.join();
+    watchdog.reset();
+
+    watchdogActive.store(false);
+}
+
+uint64_t ThreadPool::stallCount() const {
+    return stalls.load();
+}
+
 }
\ No newline at end of file
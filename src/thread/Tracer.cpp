@@ -0,0 +1,229 @@
+#include <asp/thread/Tracer.hpp>
+#include <asp/detail/Detail.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace asp::thread {
+
+namespace {
+    constexpr size_t CHUNK_SIZE = 1024;
+
+    struct Chunk {
+        Tracer::TaskRecord records[CHUNK_SIZE];
+        // published by the owning thread after writing a record, read by `dump`
+        std::atomic<size_t> count = 0;
+        std::atomic<Chunk*> next = nullptr;
+    };
+
+    // Records of a single thread, written only by that thread. Chunks are linked and never moved,
+    // so that `dump` can read them while the thread keeps appending.
+    struct ThreadBuffer {
+        uint32_t id;
+        std::string name;
+        Chunk* head;
+        Chunk* tail;
+
+        ThreadBuffer(uint32_t id) : id(id), head(new Chunk()), tail(head) {}
+
+        ~ThreadBuffer() {
+            auto chunk = head;
+            while (chunk) {
+                auto next = chunk->next.load(std::memory_order::relaxed);
+                delete chunk;
+                chunk = next;
+            }
+        }
+
+        void push(const Tracer::TaskRecord& record) {
+            size_t n = tail->count.load(std::memory_order::relaxed);
+
+            if (n == CHUNK_SIZE) {
+                auto chunk = new Chunk();
+                tail->next.store(chunk, std::memory_order::release);
+                tail = chunk;
+                n = 0;
+            }
+
+            tail->records[n] = record;
+            tail->count.store(n + 1, std::memory_order::release);
+        }
+    };
+
+    // Buffers are owned by the registry rather than by the threads, so records survive the threads that wrote them.
+    struct Registry {
+        std::mutex mtx;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        std::atomic<uint64_t> nextTaskId = 1;
+    };
+
+    Registry& registry() {
+        return asp::detail::leakedGlobal<Registry>();
+    }
+
+    ThreadBuffer& threadBuffer() {
+        static thread_local ThreadBuffer* buffer = [] {
+            auto& reg = registry();
+            std::lock_guard lock(reg.mtx);
+
+            auto buf = std::make_unique<ThreadBuffer>(static_cast<uint32_t>(reg.buffers.size() + 1));
+            auto ptr = buf.get();
+            reg.buffers.push_back(std::move(buf));
+
+            return ptr;
+        }();
+
+        return *buffer;
+    }
+
+    void writeString(std::ostream& out, const char* str) {
+        out << '"';
+
+        for (; *str; str++) {
+            char c = *str;
+
+            switch (c) {
+                case '"': out << "\\\""; break;
+                case '\\': out << "\\\\"; break;
+                case '\n': out << "\\n"; break;
+                case '\t': out << "\\t"; break;
+                default:
+                    if (static_cast<unsigned char>(c) < 0x20) {
+                        out << ' ';
+                    } else {
+                        out << c;
+                    }
+            }
+        }
+
+        out << '"';
+    }
+
+    double micros(uint64_t ns) {
+        return static_cast<double>(ns) / 1000.0;
+    }
+}
+
+void Tracer::enable() {
+    // make sure the epoch is set before the first timestamp
+    (void) registry();
+    enabledFlag.store(true, std::memory_order::relaxed);
+}
+
+void Tracer::disable() {
+    enabledFlag.store(false, std::memory_order::relaxed);
+}
+
+uint64_t Tracer::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - registry().epoch).count();
+}
+
+uint32_t Tracer::threadId() {
+    return threadBuffer().id;
+}
+
+void Tracer::setThreadName(std::string name) {
+    auto& buf = threadBuffer();
+    std::lock_guard lock(registry().mtx);
+    buf.name = std::move(name);
+}
+
+uint64_t Tracer::nextTaskId() {
+    return registry().nextTaskId.fetch_add(1, std::memory_order::relaxed);
+}
+
+void Tracer::record(const TaskRecord& record) {
+    threadBuffer().push(record);
+}
+
+void Tracer::dump(std::ostream& out) {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mtx);
+
+    // timestamps are in microseconds with nanosecond precision
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+
+    auto sep = [&] {
+        if (!first) out << ",\n";
+        first = false;
+    };
+
+    for (auto& buf : reg.buffers) {
+        if (buf->name.empty()) continue;
+
+        sep();
+        out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buf->id << ",\"args\":{\"name\":";
+        writeString(out, buf->name.c_str());
+        out << "}}";
+    }
+
+    for (auto& buf : reg.buffers) {
+        for (auto chunk = buf->head; chunk; chunk = chunk->next.load(std::memory_order::acquire)) {
+            size_t count = chunk->count.load(std::memory_order::acquire);
+
+            for (size_t i = 0; i < count; i++) {
+                auto& r = chunk->records[i];
+
+                // the task itself, on the worker that ran it
+                sep();
+                out << "{\"ph\":\"X\",\"cat\":\"task\",\"name\":";
+                writeString(out, r.label ? r.label : "task");
+                out << ",\"pid\":1,\"tid\":" << r.worker
+                    << ",\"ts\":" << micros(r.startTime)
+                    << ",\"dur\":" << micros(r.endTime - r.startTime)
+                    << ",\"args\":{\"id\":" << r.id
+                    << ",\"queued_us\":" << micros(r.dequeueTime - r.spawnTime)
+                    << ",\"spawn_ts\":" << micros(r.spawnTime)
+                    << ",\"dequeue_ts\":" << micros(r.dequeueTime)
+                    << "}}";
+
+                // flow arrow from the spawning thread to the start of the task
+                sep();
+                out << "{\"ph\":\"s\",\"cat\":\"spawn\",\"name\":\"spawn\",\"id\":" << r.id
+                    << ",\"pid\":1,\"tid\":" << r.spawnThread << ",\"ts\":" << micros(r.spawnTime) << "}";
+
+                sep();
+                out << "{\"ph\":\"f\",\"bp\":\"e\",\"cat\":\"spawn\",\"name\":\"spawn\",\"id\":" << r.id
+                    << ",\"pid\":1,\"tid\":" << r.worker << ",\"ts\":" << micros(r.startTime) << "}";
+            }
+        }
+    }
+
+    out << "]}\n";
+}
+
+bool Tracer::dumpToFile(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) return false;
+
+    dump(file);
+    return static_cast<bool>(file);
+}
+
+void Tracer::clear() {
+    auto& reg = registry();
+    std::lock_guard lock(reg.mtx);
+
+    for (auto& buf : reg.buffers) {
+        auto chunk = buf->head->next.exchange(nullptr, std::memory_order::relaxed);
+
+        while (chunk) {
+            auto next = chunk->next.load(std::memory_order::relaxed);
+            delete chunk;
+            chunk = next;
+        }
+
+        buf->head->count.store(0, std::memory_order::relaxed);
+        buf->tail = buf->head;
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+// Connects to a loopback listener through the reactor, including while the listen backlog is full,
+// and checks that the future only completes once the connection is actually established.
+
+#include <asp/async.hpp>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace asp::async;
+
+#define CHECK(cond) if (!(cond)) { std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); return 1; }
+
+static int makeSocket() {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+static bool isConnected(int fd) {
+    sockaddr_in peer{};
+    socklen_t len = sizeof(peer);
+    return ::getpeername(fd, reinterpret_cast<sockaddr*>(&peer), &len) == 0;
+}
+
+int main() {
+    int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrlen = sizeof(addr);
+
+    CHECK(::bind(listener, reinterpret_cast<sockaddr*>(&addr), addrlen) == 0);
+    CHECK(::getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addrlen) == 0);
+    CHECK(::listen(listener, 0) == 0);
+
+    // fill up the backlog, so that further connections stay pending until something is accepted
+    std::vector<int> clients;
+    std::vector<FutureHandle<void>> pending;
+
+    for (int i = 0; i < 8; i++) {
+        int fd = makeSocket();
+        clients.push_back(fd);
+        pending.push_back(asyncConnect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)));
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    // every connection that is reported as established must really be connected
+    for (size_t i = 0; i < clients.size(); i++) {
+        if (pending[i].hasFinished()) {
+            CHECK(!pending[i].hasError());
+            CHECK(isConnected(clients[i]));
+        }
+    }
+
+    // accepting lets the pending connections through, a client may already be connected before it is accepted
+    std::atomic<bool> done = false;
+    ::fcntl(listener, F_SETFL, ::fcntl(listener, F_GETFL) | O_NONBLOCK);
+
+    std::thread acceptor([listener, &done] {
+        while (!done) {
+            int fd = ::accept(listener, nullptr, nullptr);
+
+            if (fd != -1) {
+                ::close(fd);
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    });
+
+    for (size_t i = 0; i < clients.size(); i++) {
+        pending[i].await();
+        CHECK(isConnected(clients[i]));
+    }
+
+    done = true;
+    acceptor.join();
+
+    for (int fd : clients) {
+        Reactor::get().deregister(fd);
+        ::close(fd);
+    }
+
+    ::close(listener);
+
+    std::puts("ok");
+    return 0;
+}
\ No newline at end of file